@@ -9,6 +9,7 @@
 #include <string>
 #include <sstream>
 #include <iostream>
+#include <thread>
 
 #include "Version.h"
 #include "Randomizer.h"
@@ -19,6 +20,8 @@
 #include "Watchdog.h"
 #include "Random.h"
 #include "Input.h"
+#include "ProgressChannel.h"
+#include "StartupPipeline.h"
 
 #include "Converty.h"
 #include "Archipelago/APRandomizer.h"
@@ -32,12 +35,14 @@
 #define IDC_WRITE 0x407
 #define IDC_DUMP 0x408
 #define IDT_RANDOMIZED 0x409
+#define IDT_PROGRESS 0x40A
 #define IDC_TOGGLELASERS 0x410
 #define IDC_TOGGLESNIPES 0x411
 #define IDC_SKIPPUZZLE 0x421
 #define IDC_LOADCREDENTIALS 0x422
 #define IDC_TAB 0x450
 #define IDC_RETURN 0x451
+#define WM_GENERATION_DONE (WM_APP + 1) // Posted by the generation thread once the puzzles are generated
 
 #define IDC_ADD 0x301
 #define IDC_REMOVE 0x302
@@ -80,6 +85,10 @@
 #define ARROW_DOWN_LEFT 0x707
 
 #define DEBUG false
+#define RECORD_SWITCH L"/record" // Command line switch that logs the session with the game to RECORDING_FILE, for replaying it without the game
+#define REPLAY_SWITCH L"/replay" // Command line switch that plays RECORDING_FILE back in place of the game, and sends how it differed to the debug output on exit
+#define RECORDING_FILE "WRPGrecording.bin"
+#define TRACE_SWITCH L"/trace" // Command line switch that traces every access to the game, and sends a summary to the debug output after each randomization and on exit
 
 //Panel to edit
 int panel = 0x09E69;
@@ -91,6 +100,9 @@ std::shared_ptr<APRandomizer> apRandomizer = std::make_shared<APRandomizer>();
 std::shared_ptr<Generate> generator = std::make_shared<Generate>();
 std::shared_ptr<Special> specialCase = std::make_shared<Special>(generator);
 std::vector<byte> bytes;
+ProgressQueue* loadingProgress = ProgressChannel::get()->subscribe(); //Generation progress for the loading text
+std::thread generation; //Generates the puzzles while the window stays responsive. Joinable while it runs.
+std::exception_ptr generationError;
 
 std::vector<int> addressPanels = { 0x09FA0, 0x09F86, 0x0C339, 0x09FAA, 0x0A249, 0x1C2DF, 0x1831E, 0x1C260, 0x1831C, 0x1C2F3, 0x1831D, 0x1C2B1, 0x1831B, 0x0A015 };
 std::vector<int> userPanels = { 0x17CC4, 0x275ED, 0x03678, 0x03679, 0x03675, 0x03676, 0x17CAC, 0x03852, 0x03858, 0x38663, 0x275FA, 0x334DB, 0x334DC, 0x09E49 };
@@ -126,13 +138,48 @@ LRESULT CALLBACK WndProc(HWND hwnd, UINT message, WPARAM wParam, LPARAM lParam)
 	static bool seedIsRNG = false;
 
 	if (message == WM_CLOSE) {
+		//The generation thread is still using the randomizer and the window
+		if (generation.joinable()) return 0;
 		if (MessageBox(hwnd, L"Warning: Some puzzles may be unsolvable if you close the randomizer while the game is running.\r\n\r\nExit anyway?", L"", MB_OKCANCEL) == IDOK)
 			DestroyWindow(hwnd);
 		return 0;
 	}
 	else if (message == WM_DESTROY) {
+		if (MemoryTrace::enabled()) OutputDebugStringA(MemoryTrace::report().c_str());
+		for (const std::string& divergence : Memory::replayDivergences()) OutputDebugStringA(("Replay: " + divergence + "\n").c_str());
 		PostQuitMessage(0);
-	} else if (message == WM_COMMAND || message == WM_TIMER) {
+	}
+	else if (message == WM_GENERATION_DONE) {
+		//Finish what IDC_RANDOMIZE started
+		generation.join();
+		EnableWindow(hwnd, true);
+		if (generationError) std::rethrow_exception(generationError);
+		WndProc(hwnd, WM_TIMER, IDT_PROGRESS, 0); //Show the last update
+
+		SetWindowText(hwndRandomize, L"Randomized!");
+
+		EnableWindow(hwndChallenge, true);
+
+		int puzzleRando = apRandomizer->PuzzleRandomization;
+		if (puzzleRando == SIGMA_EXPERT)
+			apRandomizer->GenerateHard(hwndSkip, hwndAvailableSkips);
+		else if (puzzleRando == SIGMA_NORMAL || puzzleRando == NO_PUZZLE_RANDO)
+			apRandomizer->GenerateNormal(hwndSkip, hwndAvailableSkips);
+
+		Special::WritePanelData(0x00064, BACKGROUND_REGION_COLOR + 12, apRandomizer->Seed);
+		Special::WritePanelData(0x00182, BACKGROUND_REGION_COLOR + 12, puzzleRando);
+
+		apRandomizer->PostGeneration(hwndLoadingText);
+
+		if (MemoryTrace::enabled()) {
+			OutputDebugStringA(MemoryTrace::report().c_str());
+			MemoryTrace::clear(); //The summary on exit only covers what came after
+		}
+
+		InputWatchdog::get()->start();
+		return 0;
+	}
+	else if (message == WM_COMMAND || message == WM_TIMER) {
 		switch (HIWORD(wParam)) {
 			// Seed contents changed
 			case EN_CHANGE:
@@ -140,6 +187,16 @@ LRESULT CALLBACK WndProc(HWND hwnd, UINT message, WPARAM wParam, LPARAM lParam)
 		}
 		switch (LOWORD(wParam)) {
 
+		case IDT_PROGRESS:
+		{
+			//Only the newest update needs to be shown
+			ProgressEvent event;
+			bool updated = false;
+			while (loadingProgress->pop(event)) updated = true;
+			if (updated) SetWindowText(hwndLoadingText, event.text().c_str());
+			break;
+		}
+
 		case IDC_TAB:
 			if(GetFocus() == hwndAddress){
 				focusEdit(hwndUser);
@@ -183,6 +240,8 @@ LRESULT CALLBACK WndProc(HWND hwnd, UINT message, WPARAM wParam, LPARAM lParam)
 		//Randomize button
 		case IDC_RANDOMIZE:
 		{
+			//Accelerators still get through while the window is disabled
+			if (generation.joinable()) break;
 			Memory::errorWindow = hwndRecentError;
 
 			bool rerandomize = false;
@@ -348,24 +407,18 @@ LRESULT CALLBACK WndProc(HWND hwnd, UINT message, WPARAM wParam, LPARAM lParam)
 
 			apRandomizer->Init();
 
-			if (puzzleRando == SIGMA_EXPERT) randomizer->GenerateHard(hwndLoadingText);
-			else if (puzzleRando == SIGMA_NORMAL) randomizer->GenerateNormal(hwndLoadingText);
-
-			SetWindowText(hwndRandomize, L"Randomized!");
-
-			EnableWindow(hwndChallenge, true);
-
-			if (puzzleRando == SIGMA_EXPERT)
-				apRandomizer->GenerateHard(hwndSkip, hwndAvailableSkips);
-			else if (puzzleRando == SIGMA_NORMAL || puzzleRando == NO_PUZZLE_RANDO)
-				apRandomizer->GenerateNormal(hwndSkip, hwndAvailableSkips);
-
-			Special::WritePanelData(0x00064, BACKGROUND_REGION_COLOR + 12, seed);
-			Special::WritePanelData(0x00182, BACKGROUND_REGION_COLOR + 12, puzzleRando);
-
-			apRandomizer->PostGeneration(hwndLoadingText);
-
-			InputWatchdog::get()->start();
+			//Generate on another thread so the window stays responsive and the loading text can be updated from the progress channel.
+			//The whole window is disabled until it posts WM_GENERATION_DONE, which does the rest.
+			EnableWindow(hwnd, false);
+			generationError = nullptr;
+			generation = std::thread([hwnd, puzzleRando]() {
+				try {
+					if (puzzleRando == SIGMA_EXPERT) randomizer->GenerateHard();
+					else if (puzzleRando == SIGMA_NORMAL) randomizer->GenerateNormal();
+				}
+				catch (...) { generationError = std::current_exception(); }
+				PostMessage(hwnd, WM_GENERATION_DONE, 0, 0);
+			});
 
 			break;
 		}
@@ -616,23 +669,34 @@ int APIENTRY wWinMain(_In_ HINSTANCE hInstance, _In_opt_ HINSTANCE hPrevInstance
 	HWND hwnd = CreateWindowEx(WS_EX_CONTROLPARENT, WINDOW_CLASS, PRODUCT_NAME, WS_OVERLAPPEDWINDOW,
       650, 200, 600, DEBUG ? 700 : 385, nullptr, nullptr, hInstance, nullptr);
 
-	//Initialize memory globals constant depending on game version
-	Memory memory("witness64_d3d11.exe");
+	if (std::wstring(lpCmdLine).find(RECORD_SWITCH) != std::wstring::npos) Memory::recordTo(RECORDING_FILE);
+	else if (std::wstring(lpCmdLine).find(REPLAY_SWITCH) != std::wstring::npos) Memory::replayFrom(RECORDING_FILE);
+	if (std::wstring(lpCmdLine).find(TRACE_SWITCH) != std::wstring::npos) MemoryTrace::enable(true);
+
+	//Attach, then try the known globals while the game's code is scanned. The scan doesn't depend on globals, so they can run together.
+	std::shared_ptr<Memory> memory;
 	Memory::showMsg = false;
-	for (int g : Memory::globalsTests) {
-		try {
-			Memory::GLOBALS = g;
-			if (memory.ReadPanelData<int>(0x17E52, STYLE_FLAGS) != 0xA040) throw std::exception();
-			break;
+	StartupPipeline startup;
+	startup.add("attach", {}, [&]() { memory = Memory::get(); });
+	startup.add("test globals", { "attach" }, [&]() {
+		//Initialize memory globals constant depending on game version
+		for (int g : Memory::globalsTests) {
+			try {
+				Memory::GLOBALS = g;
+				if (memory->ReadPanelData<int>(0x17E52, STYLE_FLAGS) != 0xA040) throw std::exception();
+				break;
+			}
+			catch (std::exception) { Memory::GLOBALS = 0; }
 		}
-		catch (std::exception) { Memory::GLOBALS = 0; }
-	}
-
-	memory.findGamelibRenderer();
-	memory.findMovementSpeed();
-	memory.findActivePanel();
-	memory.findPlayerPosition();
-	memory.findImportantFunctionAddresses();
+		memory->ClearOffsets(); //Drop anything cached while trying the wrong globals
+	});
+	startup.add("find addresses", { "attach" }, [&]() { memory->findAddresses(); });
+	startup.add("cached globals", { "test globals", "find addresses" }, [&]() {
+		if (!Memory::GLOBALS) Memory::GLOBALS = memory->LoadCachedGlobals();
+		else memory->SaveGlobals();
+	});
+	startup.run();
+	OutputDebugStringA(("Startup:\n" + startup.report()).c_str());
 
 	if (!Memory::GLOBALS) {
 		std::ifstream file("WRPGglobals.txt");
@@ -643,7 +707,7 @@ int APIENTRY wWinMain(_In_ HINSTANCE hInstance, _In_opt_ HINSTANCE hPrevInstance
 		else {
 			std::wstring str = L"Globals ptr not found. Press OK to search for globals ptr (may take a minute or two). Please keep The Witness open during this time.";
 			if (MessageBox(GetActiveWindow(), str.c_str(), NULL, MB_OK) != IDOK) return 0;
-			int address = memory.findGlobals();
+			int address = memory->findGlobals();
 			if (address) {
 				std::wstringstream ss; ss << std::hex << "Address found: 0x" << address << ". This address wil be automatically loaded next time. Please post an issue on Github with this address so that it can be added in the future.";
 				MessageBox(GetActiveWindow(), ss.str().c_str(), NULL, MB_OK);
@@ -739,6 +803,7 @@ int APIENTRY wWinMain(_In_ HINSTANCE hInstance, _In_opt_ HINSTANCE hPrevInstance
 	hwndLoadingText = CreateWindow(L"STATIC", L"",
 		WS_TABSTOP | WS_VISIBLE | WS_CHILD | SS_LEFT,
 		250, 225, 160, 16, hwnd, NULL, hInstance, NULL);
+	SetTimer(hwnd, IDT_PROGRESS, 33, NULL);
 
 	hwndAvailableSkips = CreateWindow(L"STATIC", L"",
 		WS_TABSTOP | WS_VISIBLE | WS_CHILD | SS_LEFT,
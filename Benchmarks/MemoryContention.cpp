@@ -0,0 +1,117 @@
+// This is an open source non-commercial project. Dear PVS-Studio, please check it.
+
+// PVS-Studio Static Code Analyzer for C, C++, C#, and Java: http://www.viva64.com
+
+// Measures how Memory holds up when several threads read and write panels at once, the way the watchdogs poll while the generator writes.
+// Runs against a FakeMemoryBackend, so the game doesn't have to be open. It isn't part of any project: build it as a console program together
+//   with the files in Source, for example by adding it to a new console project that references Source.vcxproj, and run it in Release.
+
+#include "../Source/Memory.h"
+#include "../Source/MemoryBackend.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <memory>
+#include <random>
+#include <thread>
+#include <vector>
+
+#define BENCH_BASE       0x140000000 // Where the fake executable is loaded
+#define BENCH_GLOBALS         0x1000 // GLOBALS, relative to the base
+#define BENCH_HEAP      0x200000000 // The globals, the panel table and the panels
+#define BENCH_PANELS           0x800 // Panels in the table
+#define BENCH_PANEL_SIZE       0x400 // Bytes of each panel entity
+#define BENCH_READ_OFFSET      0x298 // Field the readers poll
+#define BENCH_WRITE_OFFSET     0x3C0 // Field the writers change
+#define BENCH_SECONDS              2 // How long each configuration runs
+
+struct BenchResult {
+	uint64_t reads = 0;
+	uint64_t writes = 0;
+	std::chrono::nanoseconds worstRead = {}; // Longest any single read waited
+};
+
+// A fake game with BENCH_PANELS panels, laid out the way Memory finds them: GLOBALS points at the globals, whose 0x18 points at the panel table.
+static std::shared_ptr<Memory> makeMemory() {
+	std::unique_ptr<FakeMemoryBackend> backend = std::make_unique<FakeMemoryBackend>();
+	backend->addProcess("witness64_d3d11.exe", BENCH_BASE);
+
+	uintptr_t globals = BENCH_HEAP;
+	uintptr_t table = globals + 0x100;
+	uintptr_t panels = table + BENCH_PANELS * sizeof(uintptr_t);
+	std::vector<uint8_t> executable(BENCH_GLOBALS + sizeof(uintptr_t), 0);
+	std::memcpy(&executable[BENCH_GLOBALS], &globals, sizeof(globals));
+	backend->map(BENCH_BASE, executable);
+
+	std::vector<uint8_t> heap(panels - globals + BENCH_PANELS * BENCH_PANEL_SIZE, 0);
+	std::memcpy(&heap[0x18], &table, sizeof(table));
+	for (uintptr_t i = 0; i < BENCH_PANELS; i++) {
+		uintptr_t panel = panels + i * BENCH_PANEL_SIZE;
+		std::memcpy(&heap[table - globals + i * sizeof(uintptr_t)], &panel, sizeof(panel));
+	}
+	backend->map(BENCH_HEAP, heap);
+
+	Memory::GLOBALS = BENCH_GLOBALS;
+	return std::make_shared<Memory>("witness64_d3d11.exe", std::move(backend));
+}
+
+static BenchResult run(int readers, int writers) {
+	std::shared_ptr<Memory> memory = makeMemory();
+	std::atomic<bool> stop = false;
+	std::atomic<uint64_t> reads = 0, writes = 0;
+	std::atomic<int64_t> worstRead = 0;
+
+	std::vector<std::thread> threads;
+	for (int i = 0; i < readers; i++) {
+		threads.emplace_back([&, i]() {
+			std::mt19937 rng(i);
+			uint64_t count = 0;
+			int64_t worst = 0;
+			while (!stop) {
+				auto start = std::chrono::steady_clock::now();
+				memory->ReadPanelData<int>(rng() % BENCH_PANELS, BENCH_READ_OFFSET);
+				worst = std::max<int64_t>(worst, (std::chrono::steady_clock::now() - start).count());
+				count++;
+			}
+			reads += count;
+			for (int64_t seen = worstRead; worst > seen && !worstRead.compare_exchange_weak(seen, worst);) {}
+		});
+	}
+	for (int i = 0; i < writers; i++) {
+		threads.emplace_back([&, i]() {
+			std::mt19937 rng(1000 + i);
+			uint64_t count = 0;
+			while (!stop) {
+				// A new value every time, so the shadow copy can't skip the write
+				memory->WritePanelData<int>(rng() % BENCH_PANELS, BENCH_WRITE_OFFSET, { static_cast<int>(count) });
+				count++;
+			}
+			writes += count;
+		});
+	}
+
+	std::this_thread::sleep_for(std::chrono::seconds(BENCH_SECONDS));
+	stop = true;
+	for (std::thread& thread : threads) thread.join();
+
+	BenchResult result;
+	result.reads = reads;
+	result.writes = writes;
+	result.worstRead = std::chrono::nanoseconds(worstRead.load());
+	return result;
+}
+
+int main() {
+	std::printf("readers writers   reads/s  writes/s  worst read (us)\n");
+	for (int writers : { 0, 1, 4 }) {
+		for (int readers : { 1, 2, 4, 8 }) {
+			BenchResult result = run(readers, writers);
+			std::printf("%7d %7d %9llu %9llu %16lld\n", readers, writers, static_cast<unsigned long long>(result.reads / BENCH_SECONDS),
+				static_cast<unsigned long long>(result.writes / BENCH_SECONDS),
+				static_cast<long long>(std::chrono::duration_cast<std::chrono::microseconds>(result.worstRead).count()));
+		}
+	}
+	return 0;
+}
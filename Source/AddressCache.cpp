@@ -0,0 +1,98 @@
+// This is an open source non-commercial project. Dear PVS-Studio, please check it.
+
+// PVS-Studio Static Code Analyzer for C, C++, C#, and Java: http://www.viva64.com
+
+#include "AddressCache.h"
+#include <cstring>
+#include <fstream>
+#include <iomanip>
+#include <sstream>
+
+#define PE_HEADER_OFFSET 0x3C // Where the DOS header stores the offset of the PE headers
+#define PE_HEADER_SIZE   0xF0 // The PE signature, file header and 64 bit optional header. Covers TimeDateStamp, SizeOfImage and CheckSum.
+
+uint64_t AddressCache::fingerprint(const std::vector<uint8_t>& headers) {
+	if (headers.size() < PE_HEADER_OFFSET + 4 || headers[0] != 'M' || headers[1] != 'Z') return 0;
+	uint32_t peOffset;
+	std::memcpy(&peOffset, &headers[PE_HEADER_OFFSET], sizeof(peOffset));
+	if (peOffset + PE_HEADER_SIZE > headers.size() || std::memcmp(&headers[peOffset], "PE\0\0", 4) != 0) return 0;
+
+	// FNV-1a
+	uint64_t hash = 0xCBF29CE484222325;
+	for (uint32_t i = peOffset; i < peOffset + PE_HEADER_SIZE; i++) {
+		hash = (hash ^ headers[i]) * 0x100000001B3;
+	}
+	return hash;
+}
+
+static std::string toHex(const std::vector<uint8_t>& bytes) {
+	std::stringstream ss;
+	for (uint8_t b : bytes) ss << std::hex << std::setw(2) << std::setfill('0') << static_cast<int>(b);
+	return ss.str();
+}
+
+static int hexDigit(char c) {
+	if (c >= '0' && c <= '9') return c - '0';
+	if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+	if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+	return -1;
+}
+
+// False if hex isn't whole bytes of hex digits, as in a cache that was cut short or edited by hand.
+static bool fromHex(const std::string& hex, std::vector<uint8_t>& bytes) {
+	if (hex.size() % 2 != 0) return false;
+	bytes.clear();
+	for (size_t i = 0; i < hex.size(); i += 2) {
+		int high = hexDigit(hex[i]), low = hexDigit(hex[i + 1]);
+		if (high < 0 || low < 0) return false;
+		bytes.push_back(static_cast<uint8_t>(high << 4 | low));
+	}
+	return true;
+}
+
+bool AddressCache::load(const std::string& path) {
+	std::ifstream file(path);
+	if (!file.is_open()) return false;
+
+	std::string kind;
+	int version = 0;
+	file >> kind >> version;
+	if (kind != "version" || version != ADDRESS_CACHE_VERSION) return false;
+
+	values.clear();
+	probes.clear();
+	patches.clear();
+	std::string line;
+	while (std::getline(file, line)) {
+		std::stringstream ss(line);
+		if (!(ss >> kind)) continue;
+		if (kind == "executable") {
+			ss >> std::hex >> executable;
+		}
+		else if (kind == "value") {
+			std::string name;
+			uint64_t value;
+			if (ss >> name >> std::hex >> value) values[name] = value;
+		}
+		else if (kind == "probe" || kind == "patch") {
+			Bytes bytes;
+			std::string hex;
+			if (!(ss >> std::hex >> bytes.offset >> hex)) continue;
+			if (!fromHex(hex, bytes.bytes)) return false;
+			(kind == "probe" ? probes : patches).push_back(bytes);
+		}
+	}
+	return executable != 0;
+}
+
+bool AddressCache::save(const std::string& path) const {
+	std::ofstream file(path);
+	if (!file.is_open()) return false;
+
+	file << "version " << ADDRESS_CACHE_VERSION << std::endl;
+	file << "executable " << std::hex << executable << std::endl;
+	for (const auto& [name, value] : values) file << "value " << name << " " << value << std::endl;
+	for (const Bytes& probe : probes) file << "probe " << probe.offset << " " << toHex(probe.bytes) << std::endl;
+	for (const Bytes& patch : patches) file << "patch " << patch.offset << " " << toHex(patch.bytes) << std::endl;
+	return file.good();
+}
@@ -0,0 +1,31 @@
+#pragma once
+#include <cstdint>
+#include <map>
+#include <string>
+#include <vector>
+
+#define ADDRESS_CACHE_VERSION 1 // Bump when the meaning of a cached value changes, so that old caches are scanned again.
+
+// What the startup signature scans found, saved to a file so that later launches against the same executable can skip them. Addresses in
+//   the game's code are stored relative to the executable's base address, since that can change between launches.
+class AddressCache
+{
+public:
+	// Bytes at an offset from the executable's base address.
+	struct Bytes {
+		uint64_t offset;
+		std::vector<uint8_t> bytes;
+	};
+
+	// Identifies an executable by a hash of its PE headers, which include its link timestamp and image size. Returns 0 if they aren't PE headers.
+	static uint64_t fingerprint(const std::vector<uint8_t>& headers);
+
+	// Returns false if the file doesn't exist, was written by a different version or is corrupt.
+	bool load(const std::string& path);
+	bool save(const std::string& path) const;
+
+	uint64_t executable = 0; // Fingerprint of the executable the values were found in
+	std::map<std::string, uint64_t> values;
+	std::vector<Bytes> probes; // Code that has to be unchanged for the values to be trusted
+	std::vector<Bytes> patches; // Changes to the game's code made while scanning, which have to be made again when the cache is used
+};
@@ -2,6 +2,7 @@
 #include "APRandomizer.h"
 #include "APGameData.h"
 #include "../Panels.h"
+#include "../StartupPipeline.h"
 
 bool APRandomizer::Connect(HWND& messageBoxHandle, std::string& server, std::string& user, std::string& password) {
 	std::string uri = buildUri(server);
@@ -427,8 +428,11 @@ void APRandomizer::PostGeneration(HWND loadingHandle) {
 
 	async->SkipPreviouslySkippedPuzzles();
 
-	for (int panel : desertPanels) {
-		_memory->UpdatePanelJunctions(panel);
+	{
+		RemoteCallBatch batch(_memory);
+		for (int panel : desertPanels) {
+			_memory->UpdatePanelJunctions(panel);
+		}
 	}
 
 	if (FinalPanel == 0x09F7F) {
@@ -473,13 +477,18 @@ void APRandomizer::setPuzzleLocks(HWND loadingHandle) {
 }
 
 void APRandomizer::Init() {
-	mostRecentItemId = _memory->ReadPanelData<int>(0x0064, VIDEO_STATUS_COLOR + 12);
-
-	for (int panel : AllPuzzles) {
-		_memory->InitPanel(panel);
-	}
-
-	PanelRestore::RestoreOriginalPanelData(_memory);
+	//Restoring panel data has to wait for the panels to be initialized, but reading the last item doesn't wait for anything
+	StartupPipeline init;
+	init.add("read last item", {}, [&]() { mostRecentItemId = _memory->ReadPanelData<int>(0x0064, VIDEO_STATUS_COLOR + 12); });
+	init.add("init panels", {}, [&]() {
+		RemoteCallBatch batch(_memory);
+		for (int panel : AllPuzzles) {
+			_memory->InitPanel(panel);
+		}
+	});
+	init.add("restore panel data", { "init panels" }, [&]() { PanelRestore::RestoreOriginalPanelData(_memory); });
+	init.run();
+	OutputDebugStringA(("APRandomizer::Init:\n" + init.report()).c_str());
 }
 
 void APRandomizer::GenerateNormal(HWND skipButton, HWND availableSkips) {
@@ -14,7 +14,7 @@
 class APRandomizer {
 	public:
 		APRandomizer() {
-			_memory = std::make_shared<Memory>("witness64_d3d11.exe");
+			_memory = Memory::get();
 			panelLocker = new PanelLocker(_memory);
 		};
 
@@ -77,6 +77,7 @@ void APWatchdog::HandleInteractionState() {
 }
 
 void APWatchdog::CheckSolvedPanels() {
+	TraceScope trace("APWatchdog::CheckSolvedPanels");
 	std::list<int64_t> solvedLocations;
 
 	if (finalPanel != 0x09F7F && finalPanel != 0xFFF00 && ReadPanelDataIntentionallyUnsafe<int>(finalPanel, SOLVED) == 1 && !isCompleted) {
@@ -102,6 +103,22 @@ void APWatchdog::CheckSolvedPanels() {
 		}
 	}
 
+	//Read the solved state of every panel and EP that is still unchecked in one pass
+	std::vector<int> panels, eps;
+	for (auto [panelId, locationId] : panelIdToLocationId) {
+		if (panelId == 0xFFF80) continue;
+		if (allEPs.count(panelId)) eps.push_back(panelId);
+		else if (obeliskHexToEPHexes.count(panelId)) eps.insert(eps.end(), obeliskHexToEPHexes[panelId].begin(), obeliskHexToEPHexes[panelId].end());
+		else panels.push_back(panelId);
+	}
+	//Panels and EPs that couldn't be read are left out, so that they are checked again next time instead of counting as unsolved
+	std::vector<bool> panelRead, epRead;
+	std::vector<int> panelSolved = _memory->ReadPanelBatch<int>(panels, SOLVED, 1, &panelRead);
+	std::vector<int> epSolved = _memory->ReadPanelBatch<int>(eps, EP_SOLVED, 1, &epRead);
+	std::map<int, int> solved, solvedEPs;
+	for (int i = 0; i < panels.size(); i++) if (panelRead[i]) solved[panels[i]] = panelSolved[i];
+	for (int i = 0; i < eps.size(); i++) if (epRead[i]) solvedEPs[eps[i]] = epSolved[i];
+
 	auto it = panelIdToLocationId.begin();
 	while (it != panelIdToLocationId.end())
 	{
@@ -123,7 +140,7 @@ void APWatchdog::CheckSolvedPanels() {
 		}
 
 		if (allEPs.count(panelId)) {
-			if (ReadPanelData<int>(panelId, EP_SOLVED)) //TODO: Check EP solved
+			if (solvedEPs.count(panelId) && solvedEPs[panelId]) //TODO: Check EP solved
 			{
 				solvedLocations.push_back(locationId);
 
@@ -142,7 +159,7 @@ void APWatchdog::CheckSolvedPanels() {
 			bool anyNew = false;
 
 			for (auto it2 = EPSet.begin(); it2 != EPSet.end();) {
-				if (ReadPanelData<int>(*it2, EP_SOLVED)) //TODO: Check EP solved
+				if (solvedEPs.count(*it2) && solvedEPs[*it2]) //TODO: Check EP solved
 				{
 					anyNew = true;
 
@@ -248,7 +265,7 @@ void APWatchdog::CheckSolvedPanels() {
 			continue;
 		}
 
-		else if (ReadPanelData<int>(panelId, SOLVED))
+		else if (solved.count(panelId) && solved[panelId])
 		{
 			solvedLocations.push_back(locationId);
 
@@ -933,8 +950,12 @@ void APWatchdog::AudioLogPlaying() {
 	std::string line2 = "";
 	std::string line3 = "";
 
-	for (int logId : audioLogs) {
-		bool logPlaying = ReadPanelData<int>(logId, AUDIO_LOG_IS_PLAYING) != 0;
+	std::vector<int> logs(audioLogs.begin(), audioLogs.end());
+	std::vector<int> playing = _memory->ReadPanelBatch<int>(logs, AUDIO_LOG_IS_PLAYING);
+
+	for (int i = 0; i < logs.size(); i++) {
+		int logId = logs[i];
+		bool logPlaying = playing[i] != 0;
 		if (logPlaying && logId != currentAudioLog) {
 			currentAudioLog = logId;
 
@@ -997,8 +1018,13 @@ void APWatchdog::CheckEPs() {
 		ap->Get(EPIDs);
 	}
 
+	std::vector<int> eps;
+	for (auto [epID, ep] : EPIDsToEPs) eps.push_back(ep);
+	std::vector<int> solved = _memory->ReadPanelBatch<int>(eps, EP_SOLVED);
+
+	int i = 0;
 	for (auto [epID, ep] : EPIDsToEPs) {
-		if (ReadPanelData<int>(ep, EP_SOLVED)) {
+		if (solved[i++]) {
 			if (!EPStates[ep]) {
 				EPStates[ep] = true;
 
@@ -1385,27 +1411,40 @@ void APWatchdog::LookingAtObelisk() {
 	InteractionState interactionState = InputWatchdog::get()->getInteractionState();
 	if (interactionState != InteractionState::Focusing) return;
 
-	std::set<int> candidates;
+	std::map<int, float> candidates; //Bounding radius of each EP that is being looked at
 
 	auto ray = InputWatchdog::get()->getMouseRay();
 
 	std::vector<float> headPosition = ray.first;
 	std::vector<float> cursorDirection = ray.second;
 
-	for (int epID : allEPs) {
-		std::vector<float> obeliskPosition = _memory->ReadPanelData<float>(epID, POSITION, 3);
+	std::vector<int> eps(allEPs.begin(), allEPs.end());
+	std::vector<float> positions = _memory->ReadPanelBatch<float>(eps, POSITION, 3);
+	std::map<int, std::vector<float>> nearby;
+
+	for (int i = 0; i < eps.size(); i++) {
+		std::vector<float> obeliskPosition(positions.begin() + i * 3, positions.begin() + i * 3 + 3);
 
 		if (pow(headPosition[0] - obeliskPosition[0], 2) + pow(headPosition[1] - obeliskPosition[1], 2) + pow(headPosition[2] - obeliskPosition[2], 2) > 49) {
 			continue;
 		}
 
-		std::vector<float> qData = ReadPanelData<float>(epID, ORIENTATION, 4);
+		nearby[eps[i]] = obeliskPosition;
+	}
+
+	std::vector<int> nearbyEPs;
+	for (auto& [epID, position] : nearby) nearbyEPs.push_back(epID);
+	std::vector<float> orientations = _memory->ReadPanelBatch<float>(nearbyEPs, ORIENTATION, 4);
+	std::vector<float> boundingRadii = _memory->ReadPanelBatch<float>(nearbyEPs, BOUNDING_RADIUS);
+
+	for (int i = 0; i < nearbyEPs.size(); i++) {
+		int epID = nearbyEPs[i];
 
 		Quaternion q;
-		q.x = qData[0];
-		q.y = qData[1];
-		q.z = qData[2];
-		q.w = qData[3];
+		q.x = orientations[i * 4];
+		q.y = orientations[i * 4 + 1];
+		q.z = orientations[i * 4 + 2];
+		q.w = orientations[i * 4 + 3];
 
 		std::vector<float> facing = { 1, 0, 0 };
 
@@ -1413,7 +1452,7 @@ void APWatchdog::LookingAtObelisk() {
 
 		float dotProduct = cursorDirection[0] * facing[0] + cursorDirection[1] * facing[1] + cursorDirection[2] * facing[2];
 
-		if (dotProduct < 0) candidates.insert(epID);
+		if (dotProduct < 0) candidates[epID] = boundingRadii[i];
 
 		continue;
 	}
@@ -1421,8 +1460,8 @@ void APWatchdog::LookingAtObelisk() {
 	int lookingAtEP = -1;
 	float distanceToCenter = 10000000.0f;
 
-	for (int epID : candidates) {
-		std::vector<float> epPosition = _memory->ReadPanelData<float>(epID, POSITION, 3);
+	for (auto [epID, boundingRadius] : candidates) {
+		std::vector<float> epPosition = nearby[epID];
 
 		std::vector<float> v = { epPosition[0] - headPosition[0], epPosition[1] - headPosition[1], epPosition[2] - headPosition[2] };
 		float t = v[0] * cursorDirection[0] + v[1] * cursorDirection[1] + v[2] * cursorDirection[2];
@@ -1430,8 +1469,6 @@ void APWatchdog::LookingAtObelisk() {
 		
 		float distance = sqrt(pow(p[0] - epPosition[0], 2) + pow(p[1] - epPosition[1], 2) + pow(p[2] - epPosition[2], 2));
 
-		float boundingRadius = _memory->ReadPanelData<float>(epID, BOUNDING_RADIUS);
-
 		if (distance < boundingRadius && distance < distanceToCenter) {
 			distanceToCenter = distance;
 			lookingAtEP = epID;
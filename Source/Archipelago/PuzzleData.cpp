@@ -1,31 +1,27 @@
 #include "PuzzleData.h"
+#include "../PanelSchema.h"
 
 void PuzzleData::Read(std::shared_ptr<Memory> _memory) {
-	grid_size_x = _memory->ReadPanelData<int>(id, GRID_SIZE_X);
-	grid_size_y = _memory->ReadPanelData<int>(id, GRID_SIZE_Y);
-	path_width_scale = _memory->ReadPanelData<float>(id, PATH_WIDTH_SCALE);
-	pattern_scale = _memory->ReadPanelData<float>(id, PATTERN_SCALE);
-	
-	int numberOfDots = _memory->ReadPanelData<int>(id, NUM_DOTS);
-	dot_positions = _memory->ReadArray<float>(id, DOT_POSITIONS, numberOfDots * 2);
-	dot_flags = _memory->ReadArray<int>(id, DOT_FLAGS, numberOfDots);
-
-	int numberOfConnections = _memory->ReadPanelData<int>(id, NUM_CONNECTIONS);
-	dot_connections_a = _memory->ReadArray<int>(id, DOT_CONNECTION_A, numberOfConnections);
-	dot_connections_b = _memory->ReadArray<int>(id, DOT_CONNECTION_B, numberOfConnections);
-	
-	int numberOfDecorations = _memory->ReadPanelData<int>(id, NUM_DECORATIONS);
-	decorations = _memory->ReadArray<int>(id, DECORATIONS, numberOfDecorations);
-	decoration_flags = _memory->ReadArray<int>(id, DECORATION_FLAGS, numberOfDecorations);
-
-	int numberColoredRegions = _memory->ReadPanelData<int>(id, NUM_COLORED_REGIONS);
-	colored_regions = _memory->ReadArray<int>(id, COLORED_REGIONS, numberColoredRegions * 4);
-
-	outer_background_mode = _memory->ReadPanelData<int>(id, OUTER_BACKGROUND_MODE);
-	outer_background_color = _memory->ReadPanelData<float>(id, OUTER_BACKGROUND, 4);
-	background_region_color = _memory->ReadPanelData<float>(id, BACKGROUND_REGION_COLOR, 4);
-	path_color = _memory->ReadPanelData<float>(id, PATH_COLOR, 4);
-	decorationsColorsPointer = _memory->ReadPanelData<__int64>(id, DECORATION_COLORS);
+	PanelSnapshot snapshot = _memory->ReadPanelSnapshot(id);
+	grid_size_x = snapshot.get(PanelFields::GridSizeX);
+	grid_size_y = snapshot.get(PanelFields::GridSizeY);
+	path_width_scale = snapshot.get(PanelFields::PathWidthScale);
+	pattern_scale = snapshot.get(PanelFields::PatternScale);
+
+	snapshot.queueArray(PanelFields::DotPositions, dot_positions);
+	snapshot.queueArray(PanelFields::DotFlags, dot_flags);
+	snapshot.queueArray(PanelFields::DotConnectionA, dot_connections_a);
+	snapshot.queueArray(PanelFields::DotConnectionB, dot_connections_b);
+	snapshot.queueArray(PanelFields::Decorations, decorations);
+	snapshot.queueArray(PanelFields::DecorationFlags, decoration_flags);
+	snapshot.queueArray(PanelFields::ColoredRegions, colored_regions);
+	_memory->ReadArrays(snapshot);
+
+	outer_background_mode = snapshot.get(PanelFields::OuterBackgroundMode);
+	outer_background_color = snapshot.getAll(PanelFields::OuterBackground);
+	background_region_color = snapshot.getAll(PanelFields::BackgroundRegionColor);
+	path_color = snapshot.getAll(PanelFields::PathColor);
+	decorationsColorsPointer = snapshot.get<__int64>(DECORATION_COLORS);
 
 
 	if (id == 0x01983) {
@@ -83,7 +79,7 @@ void PuzzleData::Read(std::shared_ptr<Memory> _memory) {
 		}
 	}
 
-  	if (_memory->ReadPanelData<int>(id, REFLECTION_DATA))
+  	if (snapshot.get<int>(REFLECTION_DATA))
 		hasSymmetry = true;
 
 	int dotAmount = 0;
@@ -304,16 +304,16 @@ void Generate::resetConfig()
 }
 
 //Increment the counter on the progress indicator. This is called each time a puzzle is written, but may be called manually in other situations
+//The update is sent through the progress channel, so generation never waits on whoever is displaying it.
 void Generate::incrementProgress()
 {
 	_areaTotal++;
 	_genTotal++;
-	if (_handle) {
-		int total = (_totalPuzzles == 0 ? _areaPuzzles : _totalPuzzles);
-		if (total == 0) return;
-		std::wstring text = _areaName + L": " + std::to_wstring(_areaTotal) + L"/" + std::to_wstring(_areaPuzzles) + L" (" + std::to_wstring(_genTotal * 100 / total) + L"%)";
-		SetWindowText(_handle, text.c_str());
-	}
+	int attempts = _attempts;
+	_attempts = 0;
+	int total = (_totalPuzzles == 0 ? _areaPuzzles : _totalPuzzles);
+	if (total == 0) return;
+	ProgressChannel::get()->publish(_areaName, _panel ? _panel->id : 0, attempts, _areaTotal, _areaPuzzles, _genTotal * 100 / total);
 }
 
 //----------------------Private--------------------------
@@ -518,6 +518,7 @@ bool Generate::generate_maze(int id, int numStarts, int numExits)
 //if at some point the generator fails to add a symbol while still making the solution correct, the function returns false and must be called again.
 bool Generate::generate(int id, PuzzleSymbols symbols)
 {
+	_attempts++;
 	initPanel(id);
 
 	//Multiple erasers are forced to be separate by default. This is because combining them causes unpredictable and inconsistent behavior. 
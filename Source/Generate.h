@@ -8,6 +8,7 @@
 #include <set>
 #include <algorithm>
 #include "Random.h"
+#include "ProgressChannel.h"
 
 typedef std::set<Point> Shape;
 
@@ -17,9 +18,8 @@ class Generate
 public:
 	Generate() {
 		_width = _height = 0;
-		_areaTotal = _genTotal = _totalPuzzles = _areaPuzzles = _stoneTypes = 0;
+		_areaTotal = _genTotal = _totalPuzzles = _areaPuzzles = _stoneTypes = _attempts = 0;
 		_fullGaps = _bisect = _allowNonMatch = false;
-		_handle = NULL;
 		_panel = NULL;
 		_parity = -1;
 		colorblind = false;
@@ -62,7 +62,6 @@ public:
 	void setGridSize(int width, int height);
 	void setSymmetry(Panel::Symmetry symmetry);
 	void write(int id);
-	void setLoadingHandle(HWND handle) { _handle = handle; }
 	void setLoadingData(int totalPuzzles) { _totalPuzzles = totalPuzzles; _genTotal = 0; }
 	void setLoadingData(const std::wstring& areaName, int numPuzzles) { _areaName = areaName; _areaPuzzles = numPuzzles; _areaTotal = 0; }
 	void setFlag(Config option) { _config |= option; };
@@ -157,8 +156,8 @@ private:
 	std::vector<std::vector<Point>> _obstructions;
 	bool colorblind;
 
-	HWND _handle;
 	int _areaTotal, _genTotal, _areaPuzzles, _totalPuzzles;
+	int _attempts; //Number of generation attempts since the last puzzle was finished
 	std::wstring _areaName;
 
 	friend class PuzzleList;
@@ -118,10 +118,9 @@ std::pair<std::vector<float>, std::vector<float>> InputWatchdog::getMouseRay()
 
 	SIZE_T allocation_size2 = sizeof(buffer2);
 
-	LPVOID allocation_start2 = VirtualAllocEx(_memory->getHandle(), NULL, allocation_size2, MEM_COMMIT | MEM_RESERVE, PAGE_EXECUTE_READWRITE);
-	WriteProcessMemory(_memory->getHandle(), allocation_start2, buffer2, allocation_size2, NULL);
-	HANDLE thread2 = CreateRemoteThread(_memory->getHandle(), NULL, 0, (LPTHREAD_START_ROUTINE)allocation_start2, NULL, 0, 0);
-	WaitForSingleObject(thread2, INFINITE);
+	LPVOID allocation_start2 = _memory->getBackend()->alloc(allocation_size2, true);
+	_memory->getBackend()->write(allocation_start2, buffer2, allocation_size2);
+	_memory->getBackend()->execute(allocation_start2, true);
 
 	float resultDirection[3];
 	_memory->ReadAbsolute(reinterpret_cast<LPVOID>(results), resultDirection, 0xC);
@@ -327,7 +326,7 @@ void InputWatchdog::findCursorRelatedOffsets() {
 
 	cursorToDirectionFunction = _memory->getBaseAddress() + offset;
 
-	cursorResultsAllocation = VirtualAllocEx(_memory->getHandle(), NULL, sizeof(0x20), MEM_COMMIT | MEM_RESERVE, PAGE_READWRITE);
+	cursorResultsAllocation = _memory->getBackend()->alloc(sizeof(0x20), false);
 
 	return;
 }
\ No newline at end of file
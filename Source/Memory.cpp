@@ -4,95 +4,393 @@
 
 #include "Memory.h"
 #include "Memoryapi.h"
+#include "Randomizer.h"
 #include "Utilities.h"
 
-#include <psapi.h>
-#include <tlhelp32.h>
 #include <iostream>
-
-#undef PROCESSENTRY32
-#undef Process32Next
+#include <algorithm>
+#include <exception>
+#include <random>
+#include <thread>
 
 #define SIGSCAN_STRIDE   0x100000 // 100 KiB. Note that larger reads are not significantly slower than small reads, but have an increased chance of failing, since ReadProcessMemory fails if ANY of the memory is inaccessible.
 #define SIGSCAN_PADDING  0x000800 // The additional amount to scan in order to ensure that a useful amount of data is returned if the found signature is at the end of the buffer.
 #define PROGRAM_SIZE    0x5000000 // 5 MiB. (The application itself is only 4.7 MiB large.)
+#define PANEL_TABLE_BLOCK   0x400 // Number of entries of the panel pointer table that are read at once (8 KiB).
+#define PANEL_ARRAY_GAP     0x100 // Queued arrays that are at most this many bytes apart are fetched with one read.
+
+#define PROCESS_NAME "witness64_d3d11.exe"
+#define ALIVE_CHECK_INTERVAL 1000 // Milliseconds between checks that the game is still running, when the shared session is requested.
+#define ADDRESS_CACHE_FILE "WRPGaddresses.txt"
+#define ADDRESS_CACHE_HEADERS   0x400 // Bytes read from the start of the executable to fingerprint it. The PE headers are always inside this.
+#define ADDRESS_CACHE_PROBE        16 // Bytes compared at each probe to check that a cache still matches the executable.
+
+// Panel fields the game changes on its own. Writes to these are never skipped, since the shadow copy can't tell that they changed.
+static const std::pair<int, size_t> shadowVolatileFields[] = {
+	{ POSITION, ORIENTATION + 0x10 - POSITION }, // Position, scale and orientation, for entities the game moves (doors, bridges, the boat)
+	{ TRACED_EDGES, TRACED_EDGE_DATA + 0x10 - TRACED_EDGES }, // Traced edges, and the pointers to their data
+	{ FLASH_MODE, 0x4 },
+	{ SOLVED, POWER + 0x8 - SOLVED }, // Solved and power
+	{ NEEDS_REDRAW, 0x4 }, // The game clears it once it has redrawn the panel
+};
 
-Memory::Memory(const std::string& processName) {
-	std::string process32 = "witness_d3d11.exe";
+Memory::Memory(const std::string& processName) : Memory(processName, MemoryBackend::create()) {
+}
 
-	// First, get the handle of the process
-	PROCESSENTRY32 entry;
-	entry.dwSize = sizeof(entry);
-	HANDLE snapshot = CreateToolhelp32Snapshot(TH32CS_SNAPPROCESS, 0);
-	while (Process32Next(snapshot, &entry)) {
-		if (processName == entry.szExeFile) {
-			_handle = OpenProcess(PROCESS_ALL_ACCESS, FALSE, entry.th32ProcessID);
-			break;
-		}
+Memory::Memory(const std::string& processName, std::unique_ptr<MemoryBackend> backend) {
+	_processName = processName;
+	_backend = std::make_unique<TracingMemoryBackend>(std::move(backend));
+	for (PanelShard& shard : _shards) {
+		for (const auto& field : shadowVolatileFields) shard.shadow.setVolatile(field.first, field.second);
 	}
-	if (!_handle) {
-		PROCESSENTRY32 entry;
-		entry.dwSize = sizeof(entry);
-		HANDLE snapshot = CreateToolhelp32Snapshot(TH32CS_SNAPPROCESS, 0);
-		while (Process32Next(snapshot, &entry)) {
-			if (process32 == entry.szExeFile) {
-				MessageBox(GetActiveWindow(), L"You appear to be running the 32 bit version of The Witness. Please run the 64 bit version instead.", NULL, MB_OK);
-				throw std::exception("Unable to find process!");
+	Attach();
+}
+
+Memory::~Memory() {
+	Detach();
+}
+
+std::shared_ptr<Memory> Memory::get() {
+	// Message boxes are only shown once the session lock is released, so that other threads aren't held up behind them
+	std::exception_ptr error;
+	std::string message;
+	{
+		std::lock_guard<std::mutex> lock(_sessionMtx);
+		if (_gameExited) throw MemoryException(MemoryError::ProcessExited, "The game was closed");
+		if (!_session) {
+			try {
+				std::unique_ptr<MemoryBackend> backend;
+				if (!_replayPath.empty()) {
+					std::unique_ptr<ReplayMemoryBackend> replay = std::make_unique<ReplayMemoryBackend>(_replayPath);
+					_replay = replay.get();
+					backend = std::move(replay);
+				}
+				else backend = MemoryBackend::create();
+				if (!_recordPath.empty()) backend = std::make_unique<RecordingMemoryBackend>(std::move(backend), _recordPath);
+				_session = std::make_shared<Memory>(PROCESS_NAME, std::move(backend));
+				// A recording and its replay have to make the same scans, whatever is in the cache file at the time
+				_session->useAddressCache = _recordPath.empty() && _replayPath.empty();
+				_lastAliveCheck = std::chrono::steady_clock::now();
+			}
+			catch (std::exception& e) {
+				error = std::current_exception();
+				message = e.what();
+			}
+		}
+		else if (std::chrono::steady_clock::now() - _lastAliveCheck > std::chrono::milliseconds(ALIVE_CHECK_INTERVAL)) {
+			_lastAliveCheck = std::chrono::steady_clock::now();
+			if (!_session->IsProcessAlive()) {
+				// The addresses found at startup only fit the process they were found in, so the session isn't attached to a restarted game.
+				//   From now on, get() throws without asking the game again.
+				_session->Detach();
+				_gameExited = true;
+				message = "The Witness was closed. Please restart the randomizer once the game is running again.";
+				error = std::make_exception_ptr(MemoryException(MemoryError::ProcessExited, message));
 			}
 		}
-
-		MessageBox(GetActiveWindow(), L"Process not found in RAM. Please open The Witness and then try again.", NULL, MB_OK);
-		throw std::exception("Unable to find process!");
 	}
+	if (error) {
+		MessageBoxA(GetActiveWindow(), message.c_str(), NULL, MB_OK);
+		std::rethrow_exception(error);
+	}
+	return _session;
+}
 
-	// Next, get the process base address
-	DWORD numModules;
-	std::vector<HMODULE> moduleList(1024);
-	EnumProcessModulesEx(_handle, &moduleList[0], static_cast<DWORD>(moduleList.size()), &numModules, 3);
-
-	std::string name(64, '\0');
-	for (DWORD i = 0; i < numModules / sizeof(HMODULE); i++) {
-		int length = GetModuleBaseNameA(_handle, moduleList[i], &name[0], static_cast<DWORD>(name.size()));
-		name.resize(length);
-		if (processName == name) {
-			_baseAddress = (uintptr_t)moduleList[i];
-			break;
+void Memory::set(std::shared_ptr<Memory> memory) {
+	std::lock_guard<std::mutex> lock(_sessionMtx);
+	_session = memory;
+	_replay = nullptr;
+	_gameExited = false;
+	_lastAliveCheck = std::chrono::steady_clock::now();
+}
+
+void Memory::recordTo(const std::string& path) {
+	std::lock_guard<std::mutex> lock(_sessionMtx);
+	_recordPath = path;
+}
+
+void Memory::replayFrom(const std::string& path) {
+	std::lock_guard<std::mutex> lock(_sessionMtx);
+	_replayPath = path;
+}
+
+std::vector<std::string> Memory::replayDivergences() {
+	std::lock_guard<std::mutex> lock(_sessionMtx);
+	if (!_replay) return {};
+	return _replay->divergences();
+}
+
+bool Memory::IsProcessAlive() {
+	return _backend->isAlive();
+}
+
+// Open the game process and find its base address. Throws with a message for the user if it can't, but doesn't show it, since every lock is held.
+void Memory::Attach() {
+	// The base address and the backend's handle are used under every other lock, so all of them are held
+	std::lock_guard<std::recursive_mutex> lock(_mtx);
+	std::vector<std::unique_lock<std::recursive_mutex>> shardLocks = LockShards();
+	std::unique_lock<std::shared_mutex> cacheLock(_cacheMtx);
+	std::lock_guard<std::mutex> arenaLock(_arenaMtx);
+	std::unique_lock<std::shared_mutex> attachLock(_attachMtx);
+	const std::string& processName = _processName;
+	std::string process32 = "witness_d3d11.exe";
+
+	// First, attach to the process
+	if (!_backend->open(processName)) {
+		if (_backend->isRunning(process32)) {
+			throw MemoryException(MemoryError::ProcessExited, "You appear to be running the 32 bit version of The Witness. Please run the 64 bit version instead.");
 		}
+		throw MemoryException(MemoryError::ProcessExited, "Process not found in RAM. Please open The Witness and then try again.");
 	}
+
+	// Next, get the process base address
+	_baseAddress = _backend->moduleBase(processName);
 	if (_baseAddress == 0) {
 		throw std::exception("Couldn't find the base process address!");
 	}
 }
 
-Memory::~Memory() {
-	CloseHandle(_handle);
+// Close the process handle and forget everything that was cached about it.
+void Memory::Detach() {
+	std::lock_guard<std::recursive_mutex> lock(_mtx);
+	std::vector<std::unique_lock<std::recursive_mutex>> shardLocks = LockShards();
+	std::unique_lock<std::shared_mutex> cacheLock(_cacheMtx);
+	std::lock_guard<std::mutex> arenaLock(_arenaMtx);
+	std::unique_lock<std::shared_mutex> attachLock(_attachMtx);
+	_backend->close();
+	_baseAddress = 0;
+	_cacheGeneration++;
+	_computedAddresses.clear();
+	_panelBases.clear();
+	_panelBlockLoaded.clear();
+	for (PanelShard& shard : _shards) {
+		shard.arraySizes.clear();
+		shard.shadow.clear();
+	}
+	_messageAddress = 0;
+	_subtitlesStuff = 0;
+	_image = ModuleImage();
+	_calls.reset();
+	for (auto& batch : _callBatches) batch.second.calls.clear();
+	_arena.reset();
+	_arrayAllocations.clear();
+}
+
+void Memory::ClearOffsets() {
+	std::vector<std::unique_lock<std::recursive_mutex>> shardLocks = LockShards();
+	std::unique_lock<std::shared_mutex> cacheLock(_cacheMtx);
+	_cacheGeneration++;
+	_computedAddresses.clear();
+	_panelBases.clear();
+	_panelBlockLoaded.clear();
+	for (PanelShard& shard : _shards) shard.shadow.clear();
+}
+
+std::vector<std::unique_lock<std::recursive_mutex>> Memory::LockShards() {
+	std::vector<std::unique_lock<std::recursive_mutex>> locks;
+	for (PanelShard& shard : _shards) locks.emplace_back(shard.mtx);
+	return locks;
+}
+
+std::vector<std::unique_lock<std::recursive_mutex>> Memory::LockShards(const std::vector<MemoryRange>& ranges) {
+	std::array<bool, PANEL_SHARDS> used = {};
+	for (const MemoryRange& range : ranges) {
+		if (range.panel != -1) used[static_cast<unsigned>(range.panel) % PANEL_SHARDS] = true;
+	}
+	std::vector<std::unique_lock<std::recursive_mutex>> locks;
+	for (int i = 0; i < PANEL_SHARDS; i++) {
+		if (used[i]) locks.emplace_back(_shards[i].mtx);
+	}
+	return locks;
+}
+
+uint64_t Memory::BeginShadowWrite(PanelShard& shard, int panel, int offset, const void* data, size_t size) {
+	std::lock_guard<std::recursive_mutex> lock(shard.mtx);
+	if (shadowWrites && shard.shadow.matches(panel, offset, data, size)) return 0;
+	return ++shard.writes;
+}
+
+void Memory::StoreShadow(PanelShard& shard, uint64_t version, bool ok, bool write, int panel, int offset, const void* data, size_t size) {
+	std::lock_guard<std::recursive_mutex> lock(shard.mtx);
+	if (ok && shard.writes == version) shard.shadow.store(panel, offset, data, size);
+	else if (write) shard.shadow.forget(panel, offset, size);
+}
+
+void Memory::StoreShadowArray(PanelShard& shard, uint64_t version, bool ok, bool write, int panel, int offset, const void* data, size_t size) {
+	std::lock_guard<std::recursive_mutex> lock(shard.mtx);
+	if (ok && shard.writes == version) shard.shadow.storeArray(panel, offset, data, size);
+	else if (write) shard.shadow.forgetArray(panel, offset);
+}
+
+ShadowCacheStats Memory::GetShadowStats() {
+	ShadowCacheStats total;
+	for (PanelShard& shard : _shards) {
+		std::lock_guard<std::recursive_mutex> lock(shard.mtx);
+		total.hits += shard.shadow.stats().hits;
+		total.misses += shard.shadow.stats().misses;
+		total.bytesSkipped += shard.shadow.stats().bytesSkipped;
+	}
+	return total;
 }
 
 
 
 // Copied from Witness Trainer https://github.com/jbzdarkid/witness-trainer/blob/master/Source/Memory.cpp#L218
 int Memory::findGlobals() {
-	const std::vector<byte> scanBytes = {0x74, 0x41, 0x48, 0x85, 0xC0, 0x74, 0x04, 0x48, 0x8B, 0x48, 0x10};
-	std::vector<byte> buff;
-	buff.resize(SIGSCAN_STRIDE + 0x100); // padding in case the sigscan is past the end of the buffer
-
-	for (uintptr_t i = 0; i < PROGRAM_SIZE; i += SIGSCAN_STRIDE) {
-		SIZE_T numBytesWritten;
-		if (!ReadProcessMemory(_handle, reinterpret_cast<void*>(_baseAddress + i), &buff[0], buff.size(), &numBytesWritten)) continue;
-		buff.resize(numBytesWritten);
-		int index = Utilities::findSequence(buff, scanBytes);
-		if (index == -1) continue;
-
-		index = index + 0x14; // This scan targets a line slightly before the key instruction
-		// (address of next line) + (index interpreted as 4byte int)
-		Memory::GLOBALS = (int)(i + index + 4) + *(int*)&buff[index];
-		break;
-	}
+	executeSigScan({0x74, 0x41, 0x48, 0x85, 0xC0, 0x74, 0x04, 0x48, 0x8B, 0x48, 0x10}, [this](__int64 offset, int index, const std::vector<byte>& data) {
+		// This scan targets a line slightly before the key instruction
+		Memory::GLOBALS = static_cast<int>(Memory::ReadStaticInt(offset, index + 0x14, data));
+
+		return true;
+	});
 
 	return Memory::GLOBALS;
 }
 
-void Memory::findGamelibRenderer()
+// Find everything the randomizer needs from the game's code. Every signature is registered first, so the executable is only read once.
+void Memory::findAddresses() {
+	std::lock_guard<std::recursive_mutex> lock(_mtx);
+	uint64_t fingerprint = useAddressCache ? GetExecutableFingerprint() : 0;
+	AddressCache cache;
+	if (fingerprint != 0 && cache.load(ADDRESS_CACHE_FILE) && cache.executable == fingerprint && LoadAddresses(cache)) return;
+
+	_patches.clear();
+	SigScanner scanner;
+	findGamelibRenderer(scanner);
+	findMovementSpeed(scanner);
+	findActivePanel(scanner);
+	findPlayerPosition(scanner);
+	findImportantFunctionAddresses(scanner);
+	executeSigScans(scanner);
+
+	if (GAMELIB_RENDERER == 0) {
+		throw "Unable to dereference gamelib_render.";
+	}
+
+	// Only a complete scan is worth keeping. Otherwise the next launch scans again.
+	if (fingerprint != 0 && scanner.done()) SaveAddresses(fingerprint).save(ADDRESS_CACHE_FILE);
+}
+
+// Globals are found separately, and only taken from the cache if that didn't work
+int Memory::LoadCachedGlobals() {
+	AddressCache cache;
+	if (!useAddressCache || !cache.load(ADDRESS_CACHE_FILE) || cache.executable != GetExecutableFingerprint() || !cache.values.count("GLOBALS")) return 0;
+	return static_cast<int>(cache.values.at("GLOBALS"));
+}
+
+void Memory::SaveGlobals() {
+	AddressCache cache;
+	if (!useAddressCache || GLOBALS == 0 || !cache.load(ADDRESS_CACHE_FILE) || cache.executable != GetExecutableFingerprint()) return;
+	cache.values["GLOBALS"] = GLOBALS;
+	cache.save(ADDRESS_CACHE_FILE);
+}
+
+// One value found by findAddresses. Addresses in the game's code are cached relative to the base address.
+struct CachedAddress {
+	const char* name;
+	void* value;
+	size_t size;
+	bool inCode;
+};
+
+#define CACHED(name, inCode) { #name, &Memory::name, sizeof(Memory::name), inCode }
+
+static const std::vector<CachedAddress> cachedAddresses = {
+	CACHED(GAMELIB_RENDERER, false), CACHED(RUNSPEED, false), CACHED(CAMERAPOSITION, false), CACHED(ACCELERATION, false), CACHED(DECELERATION, false),
+	CACHED(relativeAddressOf6, false), CACHED(relativeBoatSpeed4Address, false), CACHED(relativeBoatSpeed3Address, false),
+	CACHED(relativeBoatSpeed2Address, false), CACHED(relativeBoatSpeed1Address, false),
+	CACHED(GESTURE_MANAGER, true), CACHED(powerNextFunction, true), CACHED(initPanelFunction, true), CACHED(openDoorFunction, true),
+	CACHED(activateLaserFunction, true), CACHED(hudTimePointer, true), CACHED(updateEntityPositionFunction, true), CACHED(displayHudFunction, true),
+	CACHED(hudMessageColorAddresses[0], true), CACHED(hudMessageColorAddresses[1], true), CACHED(hudMessageColorAddresses[2], true),
+	CACHED(setBoatSpeed, true), CACHED(boatSpeed4, true), CACHED(boatSpeed3, true), CACHED(boatSpeed2, true), CACHED(boatSpeed1, true),
+	CACHED(displaySubtitlesFunction, true), CACHED(displaySubtitlesFunction2, true), CACHED(displaySubtitlesFunction3, true),
+	CACHED(subtitlesOnOrOff, true), CACHED(subtitlesHashTable, true), CACHED(_recordPlayerUpdate, true), CACHED(_getSoundFunction, true),
+	CACHED(completeEPFunction, true), CACHED(updateJunctionsFunction, true), CACHED(addToPatternMapFunction, true),
+	CACHED(removeFromPatternMapFunction, true), CACHED(patternMap, true), CACHED(cursorSize, true), CACHED(cursorR, true), CACHED(cursorG, true),
+	CACHED(cursorB, true),
+};
+
+#undef CACHED
+
+// Function entry points that are never patched. If the code there is unchanged, the executable is the one the cache was made for.
+static const std::vector<uint64_t*> cacheProbes = {
+	&Memory::powerNextFunction, &Memory::initPanelFunction, &Memory::activateLaserFunction, &Memory::updateJunctionsFunction,
+	&Memory::completeEPFunction, &Memory::setBoatSpeed,
+};
+
+bool Memory::SnapshotImage() {
+	std::lock_guard<std::recursive_mutex> lock(_mtx);
+	return _image.load(*_backend, _baseAddress);
+}
+
+// Read the game's code from the snapshot if it has it, or from the process if not.
+bool Memory::ReadCode(uint64_t address, void* buffer, size_t size) {
+	std::lock_guard<std::recursive_mutex> lock(_mtx);
+	if (_image.read(address - _baseAddress, buffer, size)) return true;
+	return _backend->read(address, buffer, size);
+}
+
+bool Memory::Patch(uint64_t address, const void* bytes, size_t size) {
+	std::lock_guard<std::recursive_mutex> lock(_mtx);
+	const uint8_t* data = static_cast<const uint8_t*>(bytes);
+	_patches.push_back({ address - _baseAddress, std::vector<uint8_t>(data, data + size) });
+	_image.write(address - _baseAddress, bytes, size);
+	return WriteAbsolute(reinterpret_cast<LPVOID>(address), bytes, size);
+}
+
+uint64_t Memory::GetExecutableFingerprint() {
+	std::vector<uint8_t> headers(ADDRESS_CACHE_HEADERS);
+	if (!_backend->read(_baseAddress, &headers[0], headers.size())) return 0;
+	return AddressCache::fingerprint(headers);
+}
+
+bool Memory::LoadAddresses(const AddressCache& cache) {
+	for (const AddressCache::Bytes& probe : cache.probes) {
+		std::vector<uint8_t> actual(probe.bytes.size());
+		if (!_backend->read(_baseAddress + probe.offset, &actual[0], actual.size()) || actual != probe.bytes) return false;
+	}
+	for (const CachedAddress& address : cachedAddresses) {
+		if (cache.values.count(address.name) == 0) return false;
+	}
+
+	for (const CachedAddress& address : cachedAddresses) {
+		uint64_t value = cache.values.at(address.name);
+		if (address.inCode && value != 0) value += _baseAddress;
+		std::memcpy(address.value, &value, address.size);
+	}
+	ACTIVEPANELOFFSETS.clear();
+	for (int i = 0; cache.values.count("ACTIVEPANELOFFSETS" + std::to_string(i)); i++) {
+		ACTIVEPANELOFFSETS.push_back(static_cast<int>(cache.values.at("ACTIVEPANELOFFSETS" + std::to_string(i))));
+	}
+	_patches = cache.patches;
+	for (const AddressCache::Bytes& patch : _patches) {
+		WriteAbsolute(reinterpret_cast<LPVOID>(_baseAddress + patch.offset), &patch.bytes[0], patch.bytes.size());
+	}
+	return true;
+}
+
+AddressCache Memory::SaveAddresses(uint64_t fingerprint) {
+	AddressCache cache;
+	cache.executable = fingerprint;
+	for (const CachedAddress& address : cachedAddresses) {
+		uint64_t value = 0;
+		std::memcpy(&value, address.value, address.size);
+		if (address.inCode && value != 0) value -= _baseAddress;
+		cache.values[address.name] = value;
+	}
+	for (int i = 0; i < ACTIVEPANELOFFSETS.size(); i++) {
+		cache.values["ACTIVEPANELOFFSETS" + std::to_string(i)] = static_cast<uint32_t>(ACTIVEPANELOFFSETS[i]);
+	}
+	for (uint64_t* function : cacheProbes) {
+		if (*function == 0) continue;
+		AddressCache::Bytes probe = { *function - _baseAddress, std::vector<uint8_t>(ADDRESS_CACHE_PROBE) };
+		if (_backend->read(*function, &probe.bytes[0], probe.bytes.size())) cache.probes.push_back(probe);
+	}
+	cache.patches = _patches;
+	return cache;
+}
+
+void Memory::findGamelibRenderer(SigScanner& scanner)
 {
 	// Find the pointer to gamelib_renderer. A reliable access point to this is in Overlay::begin().
 	const std::vector<byte> gamelibSearchBytes = {
@@ -101,23 +399,19 @@ void Memory::findGamelibRenderer()
 		0x48, 0x8B, 0x0D  // <- MOV RCX, qword ptr [next 4 bytes]
 	};
 
-	uint64_t pointerLocation = executeSigScan(gamelibSearchBytes) + gamelibSearchBytes.size();
+	GAMELIB_RENDERER = 0;
+	scanner.add(gamelibSearchBytes, [this, size = gamelibSearchBytes.size()](__int64 offset, int index, const std::vector<byte>& data) {
+		// Since referencing global values is a relative operation, our final address is equal to the offset passed to the MOV operation, plus the address
+		//   of the instruction immediately after the call. Note that since offset is relative to the program's base address, this final
+		//   value is itself relative to the base address.
+		GAMELIB_RENDERER = static_cast<int>(Memory::ReadStaticInt(offset, index + static_cast<int>(size), data));
 
-	// Read the literal value passed to the MOV operation.
-	if (!ReadRelative(reinterpret_cast<void*>(pointerLocation), &GAMELIB_RENDERER, sizeof(int))) {
-		throw "Unable to dereference gamelib_render.";
-		GAMELIB_RENDERER = 0;
-		return;
-	}
-	
-	// Since referencing global values is a relative operation, our final address is equal to the offset passed to the MOV operation, plus the address
-	//   of the instruction immediately after the call. Note that since pointerLocation is an offset relative to the program's base address, this final
-	//   value is itself relative to the base address.
-	GAMELIB_RENDERER += pointerLocation + 0x4;
+		return true;
+	});
 }
 
-void Memory::findPlayerPosition() {
-	executeSigScan({ 0x84, 0xC0, 0x75, 0x59, 0xBA, 0x20, 0x00, 0x00, 0x00 }, [this](__int64 offset, int index, const std::vector<byte>& data) {
+void Memory::findPlayerPosition(SigScanner& scanner) {
+	scanner.add({ 0x84, 0xC0, 0x75, 0x59, 0xBA, 0x20, 0x00, 0x00, 0x00 }, [this](__int64 offset, int index, const std::vector<byte>& data) {
 		// This int is actually desired_movement_direction, which immediately preceeds camera_position
 		this->CAMERAPOSITION = Memory::ReadStaticInt(offset, index + 0x19, data) + 0x10;
 
@@ -134,13 +428,13 @@ void Memory::SetInfiniteChallenge(bool enable) {
 
 		strcpy_s(buffer, name.c_str());
 
-		auto challengeStuff = VirtualAllocEx(_handle, NULL, sizeof(buffer), MEM_COMMIT | MEM_RESERVE, PAGE_READWRITE);
+		auto challengeStuff = _backend->alloc(sizeof(buffer), false);
 		__int64 soundName = reinterpret_cast<__int64>(challengeStuff);
 		__int64 returnAddress = soundName + 0x20;
 
-		WriteProcessMemory(_handle, challengeStuff, buffer, sizeof(buffer), NULL);
+		_backend->write(challengeStuff, buffer, sizeof(buffer));
 
-		uint64_t offset = reinterpret_cast<uintptr_t>(ComputeOffset({ GLOBALS, 0x18, 0x00BFF * 8, 0 }));
+		uint64_t offset = GetPanelBase(0x00BFF);
 
 		char asmBuff[] =
 			"\x48\xB8\x00\x00\x00\x00\x00\x00\x00\x00" //mov rax, function address
@@ -190,15 +484,12 @@ void Memory::SetInfiniteChallenge(bool enable) {
 
 		SIZE_T allocation_size = sizeof(asmBuff);
 
-		LPVOID allocation_start = VirtualAllocEx(_handle, NULL, allocation_size, MEM_COMMIT | MEM_RESERVE, PAGE_EXECUTE_READWRITE);
-		WriteProcessMemory(_handle, allocation_start, asmBuff, allocation_size, NULL);
-		HANDLE thread = CreateRemoteThread(_handle, NULL, 0, (LPTHREAD_START_ROUTINE)allocation_start, NULL, 0, 0);
-
-		WaitForSingleObject(thread, INFINITE);
+		LPVOID allocation_start = _backend->alloc(allocation_size, true);
+		_backend->write(allocation_start, asmBuff, allocation_size);
+		_backend->execute(allocation_start, true);
 
 		__int64 sound_object[1];
-		SIZE_T numBytesWritten;
-		ReadProcessMemory(_handle, reinterpret_cast<LPCVOID>(returnAddress), sound_object, 8, &numBytesWritten);
+		_backend->read(reinterpret_cast<LPCVOID>(returnAddress), sound_object, 8);
 
 		_bytesLengthChallenge = sound_object[0] + 0x28;
 	}
@@ -208,13 +499,13 @@ void Memory::SetInfiniteChallenge(bool enable) {
 
 		LPVOID addressPointer = reinterpret_cast<LPVOID>(_recordPlayerUpdate);
 
-		WriteProcessMemory(_handle, addressPointer, asmBuff, sizeof(asmBuff) - 1, NULL);
+		_backend->write(addressPointer, asmBuff, sizeof(asmBuff) - 1);
 
 		char asmBuff2[] = "\x00\x00\x00"; // Length of song to 0
 
 		LPVOID addressPointer2 = reinterpret_cast<LPVOID>(_bytesLengthChallenge);
 
-		WriteProcessMemory(_handle, addressPointer2, asmBuff2, sizeof(asmBuff2) - 1, NULL);
+		_backend->write(addressPointer2, asmBuff2, sizeof(asmBuff2) - 1);
 
 
 	}
@@ -223,13 +514,13 @@ void Memory::SetInfiniteChallenge(bool enable) {
 
 		LPVOID addressPointer = reinterpret_cast<LPVOID>(_recordPlayerUpdate);
 
-		WriteProcessMemory(_handle, addressPointer, asmBuff, sizeof(asmBuff) - 1, NULL);
+		_backend->write(addressPointer, asmBuff, sizeof(asmBuff) - 1);
 
 		char asmBuff2[] = "\x67\xB1\x26"; // Length of song to original length
 
 		LPVOID addressPointer2 = reinterpret_cast<LPVOID>(_bytesLengthChallenge);
 
-		WriteProcessMemory(_handle, addressPointer2, asmBuff2, sizeof(asmBuff2) - 1, NULL);
+		_backend->write(addressPointer2, asmBuff2, sizeof(asmBuff2) - 1);
 	}
 }
 
@@ -244,11 +535,11 @@ void Memory::applyDestructivePatches() {
 
 	LPVOID addressPointer = reinterpret_cast<LPVOID>(cursorSize);
 
-	WriteProcessMemory(_handle, addressPointer, asmBuff, sizeof(asmBuff) - 1, NULL);
+	_backend->write(addressPointer, asmBuff, sizeof(asmBuff) - 1);
 }
 
-void Memory::findImportantFunctionAddresses(){
-	executeSigScan({ 0x45, 0x0F, 0x28, 0xC8, 0xF3, 0x44 }, [this](__int64 offset, int index, const std::vector<byte>& data) {
+void Memory::findImportantFunctionAddresses(SigScanner& scanner) {
+	scanner.add({ 0x45, 0x0F, 0x28, 0xC8, 0xF3, 0x44 }, [this](__int64 offset, int index, const std::vector<byte>& data) {
 		cursorSize = _baseAddress + offset + index;
 
 		for (; index < data.size(); index++) {
@@ -275,14 +566,14 @@ void Memory::findImportantFunctionAddresses(){
 		return true;
 	});
 
-	executeSigScan ({0x48, 0x8B, 0xC4, 0x48, 0x89, 0x58, 0x20, 0x48, 0x89, 0x48, 0x08, 0x55, 0x56, 0x57, 0x41, 0x54}, [this](__int64 offset, int index, const std::vector<byte>& data) {
+	scanner.add({0x48, 0x8B, 0xC4, 0x48, 0x89, 0x58, 0x20, 0x48, 0x89, 0x48, 0x08, 0x55, 0x56, 0x57, 0x41, 0x54}, [this](__int64 offset, int index, const std::vector<byte>& data) {
 		for (; index < data.size(); index++) {
 			if (data[index - 2] == 0x78 && data[index - 1] == 0x10 && data[index] == 0xE8) { // need to find actual function, which I could not get a sigscan to work for, so I did the function right before it
 				uint64_t pointerLocation = _baseAddress + offset + index + 1;
 
 				int function;
 
-				ReadAbsolute(reinterpret_cast<void*>(pointerLocation), &function, sizeof(int));
+				ReadCode(pointerLocation, &function, sizeof(int));
 
 				removeFromPatternMapFunction = pointerLocation + function + 4;
 				
@@ -290,13 +581,11 @@ void Memory::findImportantFunctionAddresses(){
 
 				uint64_t testInstruction = pointerLocation + 0x10;
 
-				LPVOID testInstructionPointer = reinterpret_cast<LPVOID>(testInstruction);
-
 				char buf[] = "\x90\x90\x90\x75"; //Change to nop nop nop jne instead of test je. Will never be equal due to the preceding code, so will always jump.
 				//This will cause memory leaks because the object is now not deleted. But that's preferrable to the game crashing.
 				//The memory leaks are about on the order of 0.1kB per "Resolving an already solved EP", an action the player shouldn't do too often.
 
-				WriteAbsolute(testInstructionPointer, buf, sizeof(buf) -1); // Write the new relative address into the "movss xmm0 [address]" statement.
+				Patch(testInstruction, buf, sizeof(buf) -1); // Write the new relative address into the "movss xmm0 [address]" statement.
 
 
 				break;
@@ -311,7 +600,7 @@ void Memory::findImportantFunctionAddresses(){
 
 				int function;
 
-				ReadAbsolute(reinterpret_cast<void*>(pointerLocation), &function, sizeof(int));
+				ReadCode(pointerLocation, &function, sizeof(int));
 
 				addToPatternMapFunction = pointerLocation + function + 4;
 
@@ -325,7 +614,7 @@ void Memory::findImportantFunctionAddresses(){
 
 				int function;
 
-				ReadAbsolute(reinterpret_cast<void*>(pointerLocation), &function, sizeof(int));
+				ReadCode(pointerLocation, &function, sizeof(int));
 
 				patternMap = pointerLocation + function + 4;
 
@@ -336,13 +625,13 @@ void Memory::findImportantFunctionAddresses(){
 		return true;
 	});
 
-	executeSigScan({ 0x48, 0x89, 0x6C, 0x24, 0x18, 0x57, 0x8B, 0x81 }, [this](__int64 offset, int index, const std::vector<byte>& data) {
+	scanner.add({ 0x48, 0x89, 0x6C, 0x24, 0x18, 0x57, 0x8B, 0x81 }, [this](__int64 offset, int index, const std::vector<byte>& data) {
 		this->updateJunctionsFunction = _baseAddress + offset + index;
 
 		return true;
 	});
 
-	executeSigScan({ 0x48, 0x89, 0x5C, 0x24, 0x10, 0x48, 0x89, 0x74, 0x24, 0x18, 0x57, 0x48, 0x83, 0xEC, 0x20, 0x49, 0x8B, 0xF8, 0x48, 0x8B, 0xF2, 0x48, 0x8B, 0xD9 }, [this](__int64 offset, int index, const std::vector<byte>& data) {
+	scanner.add({ 0x48, 0x89, 0x5C, 0x24, 0x10, 0x48, 0x89, 0x74, 0x24, 0x18, 0x57, 0x48, 0x83, 0xEC, 0x20, 0x49, 0x8B, 0xF8, 0x48, 0x8B, 0xF2, 0x48, 0x8B, 0xD9 }, [this](__int64 offset, int index, const std::vector<byte>& data) {
 		this->_getSoundFunction = _baseAddress + offset + index;
 
 		return true;
@@ -350,14 +639,14 @@ void Memory::findImportantFunctionAddresses(){
 
 	
 
-	executeSigScan({ 0x00, 0x00, 0x00, 0x05, 0x00, 0x00, 0x00, 0xE9, 0xB3 }, [this](__int64 offset, int index, const std::vector<byte>& data) {
+	scanner.add({ 0x00, 0x00, 0x00, 0x05, 0x00, 0x00, 0x00, 0xE9, 0xB3 }, [this](__int64 offset, int index, const std::vector<byte>& data) {
 		this->_recordPlayerUpdate = _baseAddress + offset + index - 0x0C;
 
 		return true;
 	});
 
 	//open door
-	executeSigScan({ 0x0F, 0x57, 0xC9, 0x48, 0x8B, 0xCB, 0x48, 0x83, 0xC4, 0x20 }, [this](__int64 offset, int index, const std::vector<byte>& data) {
+	scanner.add({ 0x0F, 0x57, 0xC9, 0x48, 0x8B, 0xCB, 0x48, 0x83, 0xC4, 0x20 }, [this](__int64 offset, int index, const std::vector<byte>& data) {
 		for (; index < data.size(); index++) {
 			if (data[index - 2] == 0xF3 && data[index - 1] == 0x0F) { // need to find actual function, which I could not get a sigscan to work for, so I did the function right before it
 				this->openDoorFunction = _baseAddress + offset + index - 2;
@@ -369,14 +658,14 @@ void Memory::findImportantFunctionAddresses(){
 	});
 
 	//init panel
-	executeSigScan({ 0x48, 0x89, 0x74, 0x24, 0x48, 0xFF, 0xC9, 0x8D, 0x70, 0xFF, 0x48, 0x89, 0x7C }, [this](__int64 offset, int index, const std::vector<byte>& data) {
+	scanner.add({ 0x48, 0x89, 0x74, 0x24, 0x48, 0xFF, 0xC9, 0x8D, 0x70, 0xFF, 0x48, 0x89, 0x7C }, [this](__int64 offset, int index, const std::vector<byte>& data) {
 		this->initPanelFunction = _baseAddress + offset + index - 0x32;
 
 		return true;
 	});
 
 	//display subtitles
-	executeSigScan({ 0x48, 0x89, 0xB4, 0x24, 0xC8, 0x00, 0x00, 0x00, 0x48, 0x8D, 0x4B, 0x08, 0x4C, 0x8D, 0x84, 0x24 }, [this](__int64 offset, int index, const std::vector<byte>& data) {
+	scanner.add({ 0x48, 0x89, 0xB4, 0x24, 0xC8, 0x00, 0x00, 0x00, 0x48, 0x8D, 0x4B, 0x08, 0x4C, 0x8D, 0x84, 0x24 }, [this](__int64 offset, int index, const std::vector<byte>& data) {
 		this->displaySubtitlesFunction = _baseAddress + offset + index - 9;
 
 		for (; index < data.size(); index--) { // find rax statement at start of function (Subtitles setting)
@@ -385,7 +674,7 @@ void Memory::findImportantFunctionAddresses(){
 				
 				int buff[1];
 
-				ReadProcessMemory(_handle, reinterpret_cast<LPCVOID>(raxstatement), buff, sizeof(buff), NULL);
+				ReadCode(raxstatement, buff, sizeof(buff));
 
 				this->subtitlesOnOrOff = raxstatement + buff[0] + 4;
 				
@@ -399,7 +688,7 @@ void Memory::findImportantFunctionAddresses(){
 
 				int buff[1];
 
-				ReadProcessMemory(_handle, reinterpret_cast<LPCVOID>(rbxstatement), buff, sizeof(buff), NULL);
+				ReadCode(rbxstatement, buff, sizeof(buff));
 
 				this->subtitlesHashTable = rbxstatement + buff[0] + 4;
 
@@ -411,14 +700,14 @@ void Memory::findImportantFunctionAddresses(){
 	});
 
 	//display subtitles2
-	executeSigScan({ 0xF3, 0x0F, 0x10, 0x8C, 0x24, 0xE0, 0x00, 0x00, 0x00, 0x8B, 0xCE, 0x4C, 0x8B, 0xC0, 0x48, 0x89, 0xBC }, [this](__int64 offset, int index, const std::vector<byte>& data) {
+	scanner.add({ 0xF3, 0x0F, 0x10, 0x8C, 0x24, 0xE0, 0x00, 0x00, 0x00, 0x8B, 0xCE, 0x4C, 0x8B, 0xC0, 0x48, 0x89, 0xBC }, [this](__int64 offset, int index, const std::vector<byte>& data) {
 		this->displaySubtitlesFunction2 = _baseAddress + offset + index;
 		
 		return true;
 	});
 
 	//display subtitles3
-	executeSigScan({0xC4, 0xD0, 0x00, 0x00, 0x00, 0x41, 0x5E, 0x5F, 0x5D, 0xC3 }, [this](__int64 offset, int index, const std::vector<byte>& data) {
+	scanner.add({0xC4, 0xD0, 0x00, 0x00, 0x00, 0x41, 0x5E, 0x5F, 0x5D, 0xC3 }, [this](__int64 offset, int index, const std::vector<byte>& data) {
 		for (; index < data.size(); index++) {
 			if (data[index] == 0x48  && data[index + 1] == 0x89 && data[index + 2] == 0x5C) { // need to find actual function, which I could not get a sigscan to work for, so I did the function right before it
 				this->displaySubtitlesFunction3 = _baseAddress + offset + index;
@@ -431,28 +720,28 @@ void Memory::findImportantFunctionAddresses(){
 
 
 	//Update Entity Position
-	executeSigScan({ 0x44, 0x0F, 0xB6, 0xCA, 0x4C, 0x8D, 0x41, 0x34 }, [this](__int64 offset, int index, const std::vector<byte>& data) {
+	scanner.add({ 0x44, 0x0F, 0xB6, 0xCA, 0x4C, 0x8D, 0x41, 0x34 }, [this](__int64 offset, int index, const std::vector<byte>& data) {
 		this->updateEntityPositionFunction = _baseAddress + offset + index;
 
 		return true;
 	});
 
 	//Update Entity Position
-	executeSigScan({ 0x57, 0x48, 0x83, 0xEC, 0x20, 0x48, 0x8B, 0x42, 0x18, 0x48, 0x8B, 0xFA, 0x48, 0x85, 0xC0, 0x0F, 0x84 }, [this](__int64 offset, int index, const std::vector<byte>& data) {
+	scanner.add({ 0x57, 0x48, 0x83, 0xEC, 0x20, 0x48, 0x8B, 0x42, 0x18, 0x48, 0x8B, 0xFA, 0x48, 0x85, 0xC0, 0x0F, 0x84 }, [this](__int64 offset, int index, const std::vector<byte>& data) {
 		this->powerNextFunction = _baseAddress + offset + index - 8;
 
 		return true;
 	});
 
 	//Activate Laser
-	executeSigScan({ 0x40, 0x53, 0x48, 0x83, 0xEC, 0x60, 0x83, 0xB9 }, [this](__int64 offset, int index, const std::vector<byte>& data) {
+	scanner.add({ 0x40, 0x53, 0x48, 0x83, 0xEC, 0x60, 0x83, 0xB9 }, [this](__int64 offset, int index, const std::vector<byte>& data) {
 		this->activateLaserFunction = _baseAddress + offset + index;
 
 		return true;
 	});
 
 	//Display Hud + change hudTime
-	executeSigScan({ 0x40, 0x53, 0x48, 0x83, 0xEC, 0x20, 0x83, 0x3D }, [this](__int64 offset, int index, const std::vector<byte>& data) {
+	scanner.add({ 0x40, 0x53, 0x48, 0x83, 0xEC, 0x20, 0x83, 0x3D }, [this](__int64 offset, int index, const std::vector<byte>& data) {
 		this->displayHudFunction = _baseAddress + offset + index;
 
 		for (; index < data.size(); index++) {
@@ -461,7 +750,7 @@ void Memory::findImportantFunctionAddresses(){
 
 				int buff[1];
 
-				ReadProcessMemory(_handle, reinterpret_cast<LPCVOID>(this->hudTimePointer), buff, sizeof(buff), NULL);
+				ReadCode(this->hudTimePointer, buff, sizeof(buff));
 
 				this->relativeAddressOf6 = buff[0];
 
@@ -481,7 +770,7 @@ void Memory::findImportantFunctionAddresses(){
 	});
 
 	// Find hud_draw_headline and its three hardcoded float values for R, G, and B.
-	executeSigScan({ 0x48, 0x83, 0xEC, 0x68, 0xF2, 0x0F, 0x10, 0x05 }, [this](__int64 offset, int index, const std::vector<byte>& data) {
+	scanner.add({ 0x48, 0x83, 0xEC, 0x68, 0xF2, 0x0F, 0x10, 0x05 }, [this](__int64 offset, int index, const std::vector<byte>& data) {
 		// hud_draw_headline draws text twice: once for black text to use as a drop shadow and once using values that are assigned at runtime from hardcoded values. We need to
 		//   find the addresses of the three hardcoded values (which are all 1.0f) and store them off to be overwritten in the future.
 		uint64_t functionAddress = _baseAddress + offset + index;
@@ -492,8 +781,7 @@ void Memory::findImportantFunctionAddresses(){
 		std::vector<byte> functionBody;
 		functionBody.resize(functionSize);
 
-		SIZE_T numBytesWritten;
-		ReadProcessMemory(_handle, reinterpret_cast<void*>(functionAddress), &functionBody[0], functionSize, &numBytesWritten);
+		ReadCode(functionAddress, &functionBody[0], functionSize);
 
 		// Find all three instances of 1.0f. (0x3f800000)
 		std::vector<int> foundIndices = Utilities::findAllSequences(functionBody, { 0x00, 0x00, 0x80, 0x3f });
@@ -512,7 +800,7 @@ void Memory::findImportantFunctionAddresses(){
 
 	//Boat speed
 	//Find Entity_Boat::set_speed
-	executeSigScan({0x48, 0x89, 0x5C, 0x24, 0x08, 0x57, 0x48, 0x83, 0xEC, 0x40, 0x0F, 0x29, 0x74, 0x24, 0x30, 0x8B, 0xFA }, [this](__int64 offset, int index, const std::vector<byte>& data) {
+	scanner.add({0x48, 0x89, 0x5C, 0x24, 0x08, 0x57, 0x48, 0x83, 0xEC, 0x40, 0x0F, 0x29, 0x74, 0x24, 0x30, 0x8B, 0xFA }, [this](__int64 offset, int index, const std::vector<byte>& data) {
 		this->setBoatSpeed = _baseAddress + offset + index;
 
 		for (; index < data.size(); index++) { // We now need to look for "cmp edi 04", "cmp edi 03", "cmp edi 02", and "cmp edi 01"
@@ -522,7 +810,7 @@ void Memory::findImportantFunctionAddresses(){
 
 				int buff[1];
 
-				ReadProcessMemory(_handle, reinterpret_cast<LPCVOID>(this->boatSpeed4), buff, sizeof(buff), NULL); // Read the current address of the constant loaded into xmm0 relative to the instruction
+				ReadCode(this->boatSpeed4, buff, sizeof(buff)); // Read the current address of the constant loaded into xmm0 relative to the instruction
 
 				this->relativeBoatSpeed4Address = buff[0]; // This is now the address of the constant !!relative to the movss instruction!!
 
@@ -533,10 +821,8 @@ void Memory::findImportantFunctionAddresses(){
 
 					__int32 urelativeBoatSpeed4Address = this->relativeBoatSpeed4Address;
 					__int64 address = this->boatSpeed4;
-					LPVOID addressPointer = reinterpret_cast<LPVOID>(address);
-
 
-					WriteAbsolute(addressPointer, &urelativeBoatSpeed4Address, sizeof(urelativeBoatSpeed4Address)); // Write the new relative address into the "movss xmm0 [address]" statement.
+					Patch(address, &urelativeBoatSpeed4Address, sizeof(urelativeBoatSpeed4Address)); // Write the new relative address into the "movss xmm0 [address]" statement.
 
 					return true;
 				}, boatSpeed4Address); // Start this Sigscan for a new constant at the location of the original constant to find one "nearby"
@@ -546,7 +832,7 @@ void Memory::findImportantFunctionAddresses(){
 
 				int buff[1];
 
-				ReadProcessMemory(_handle, reinterpret_cast<LPCVOID>(this->boatSpeed3), buff, sizeof(buff), NULL);
+				ReadCode(this->boatSpeed3, buff, sizeof(buff));
 
 				this->relativeBoatSpeed3Address = buff[0];
 
@@ -557,10 +843,8 @@ void Memory::findImportantFunctionAddresses(){
 
 					__int32 urelativeBoatSpeed3Address = this->relativeBoatSpeed3Address;
 					__int64 address = this->boatSpeed3;
-					LPVOID addressPointer = reinterpret_cast<LPVOID>(address);
 
-
-					WriteAbsolute(addressPointer, &urelativeBoatSpeed3Address, sizeof(urelativeBoatSpeed3Address));
+					Patch(address, &urelativeBoatSpeed3Address, sizeof(urelativeBoatSpeed3Address));
 
 					return true;
 					}, boatSpeed3Address);
@@ -570,7 +854,7 @@ void Memory::findImportantFunctionAddresses(){
 
 				int buff[1];
 
-				ReadProcessMemory(_handle, reinterpret_cast<LPCVOID>(this->boatSpeed2), buff, sizeof(buff), NULL);
+				ReadCode(this->boatSpeed2, buff, sizeof(buff));
 
 				this->relativeBoatSpeed2Address = buff[0];
 
@@ -581,10 +865,8 @@ void Memory::findImportantFunctionAddresses(){
 
 					__int32 urelativeBoatSpeed2Address = this->relativeBoatSpeed2Address;
 					__int64 address = this->boatSpeed2;
-					LPVOID addressPointer = reinterpret_cast<LPVOID>(address);
-
 
-					WriteAbsolute(addressPointer, &urelativeBoatSpeed2Address, sizeof(urelativeBoatSpeed2Address));
+					Patch(address, &urelativeBoatSpeed2Address, sizeof(urelativeBoatSpeed2Address));
 
 					return true;
 					}, boatSpeed2Address);
@@ -594,7 +876,7 @@ void Memory::findImportantFunctionAddresses(){
 
 				int buff[1];
 
-				ReadProcessMemory(_handle, reinterpret_cast<LPCVOID>(this->boatSpeed1), buff, sizeof(buff), NULL);
+				ReadCode(this->boatSpeed1, buff, sizeof(buff));
 
 				this->relativeBoatSpeed1Address = buff[0];
 
@@ -605,10 +887,8 @@ void Memory::findImportantFunctionAddresses(){
 
 					__int32 urelativeBoatSpeed1Address = this->relativeBoatSpeed1Address;
 					__int64 address = this->boatSpeed1;
-					LPVOID addressPointer = reinterpret_cast<LPVOID>(address);
 
-
-					WriteAbsolute(addressPointer, &urelativeBoatSpeed1Address, sizeof(urelativeBoatSpeed1Address));
+					Patch(address, &urelativeBoatSpeed1Address, sizeof(urelativeBoatSpeed1Address));
 
 					return true;
 					}, boatSpeed1Address);
@@ -619,28 +899,26 @@ void Memory::findImportantFunctionAddresses(){
 		return true;
 	});
 
-	executeSigScan({ 0xF3, 0x0F, 0x59, 0xF0, 0xF3, 0x41, 0x0F, 0x58, 0xF0, 0x0F, 0x2F, 0xFA }, [this](__int64 offset, int index, const std::vector<byte>& data) {
+	scanner.add({ 0xF3, 0x0F, 0x59, 0xF0, 0xF3, 0x41, 0x0F, 0x58, 0xF0, 0x0F, 0x2F, 0xFA }, [this](__int64 offset, int index, const std::vector<byte>& data) {
 		__int64 comissStatement = _baseAddress + offset + index + 0xE;
 
 		char asmBuff[] = // Bypass the upper bound check (comiss) for the boat speed
 			"\x38\xC0\x90\x90\x90\x90\x90"; //cmp al,al
 
-		LPVOID addressPointer = reinterpret_cast<LPVOID>(comissStatement);
-
-		WriteProcessMemory(_handle, addressPointer, asmBuff, sizeof(asmBuff) - 1, NULL);
+		Patch(comissStatement, asmBuff, sizeof(asmBuff) - 1);
 
 		return true;
 	});
 
-	executeSigScan({ 0x45, 0x8B, 0xF7, 0x48, 0x8B, 0x4D }, [this](__int64 offset, int index, const std::vector<byte>& data) {
+	scanner.add({ 0x45, 0x8B, 0xF7, 0x48, 0x8B, 0x4D }, [this](__int64 offset, int index, const std::vector<byte>& data) {
 		byte newByte = 0xEB;
 
-		WriteAbsolute(reinterpret_cast<LPVOID>(_baseAddress + offset + index + 0x15), &newByte, sizeof(newByte));
+		Patch(_baseAddress + offset + index + 0x15, &newByte, sizeof(newByte));
 
 		return true;
 	});
 
-	executeSigScan({ 0x48, 0x8B, 0x51, 0x18, 0x2B, 0x42, 0x08, 0x78, 0x37 }, [this](__int64 offset, int index, const std::vector<byte>& data) {
+	scanner.add({ 0x48, 0x8B, 0x51, 0x18, 0x2B, 0x42, 0x08, 0x78, 0x37 }, [this](__int64 offset, int index, const std::vector<byte>& data) {
 		for (; index < data.size(); index--) {
 			if (data[index] == 0x40 && data[index + 1] == 0x53 && data[index + 2] == 0x48) { // need to find function start (backwards)
 				this->completeEPFunction = _baseAddress + offset + index;
@@ -651,13 +929,13 @@ void Memory::findImportantFunctionAddresses(){
 		return true;
 	});
 
-	executeSigScan({ 0x66, 0x0F, 0x6E, 0xD9, 0x0F, 0x5B, 0xDB }, [this](__int64 offset, int index, const std::vector<byte>& data) {
+	scanner.add({ 0x66, 0x0F, 0x6E, 0xD9, 0x0F, 0x5B, 0xDB }, [this](__int64 offset, int index, const std::vector<byte>& data) {
 		for (; index < data.size(); index++) {
 			if (data[index] == 0x48 && data[index - 5] == 0xE8 && data[index - 10] == 0xE8 && data[index + 7] == 0xE8 && (data[index + 12] == 0x39 || data[index + 12] == 0x83)) {
 				this->GESTURE_MANAGER = _baseAddress + offset + index + 3;
 				
 				int addOffset = 0;
-				ReadAbsolute(reinterpret_cast<LPVOID>(this->GESTURE_MANAGER), &addOffset, 0x4);
+				ReadCode(this->GESTURE_MANAGER, &addOffset, 0x4);
 
 				this->GESTURE_MANAGER += addOffset + 0x4;
 			}
@@ -667,8 +945,8 @@ void Memory::findImportantFunctionAddresses(){
 	});
 }
 
-void Memory::findMovementSpeed() {
-	executeSigScan({ 0xF3, 0x0F, 0x59, 0xFD, 0xF3, 0x0F, 0x5C, 0xC8 }, [this](__int64 offset, int index, const std::vector<byte>& data) {
+void Memory::findMovementSpeed(SigScanner& scanner) {
+	scanner.add({ 0xF3, 0x0F, 0x59, 0xFD, 0xF3, 0x0F, 0x5C, 0xC8 }, [this](__int64 offset, int index, const std::vector<byte>& data) {
 		int found = 0;
 		// This doesn't have a consistent offset from the scan, so search until we find "jmp +08"
 		for (; index < data.size(); index++) {
@@ -692,8 +970,8 @@ void Memory::findMovementSpeed() {
 		});
 }
 
-void Memory::findActivePanel() {
-	executeSigScan({ 0xF2, 0x0F, 0x58, 0xC8, 0x66, 0x0F, 0x5A, 0xC1, 0xF2 }, [this](__int64 offset, int index, const std::vector<byte>& data) {
+void Memory::findActivePanel(SigScanner& scanner) {
+	scanner.add({ 0xF2, 0x0F, 0x58, 0xC8, 0x66, 0x0F, 0x5A, 0xC1, 0xF2 }, [this](__int64 offset, int index, const std::vector<byte>& data) {
 		this->ACTIVEPANELOFFSETS = {};
 		this->ACTIVEPANELOFFSETS.push_back(Memory::ReadStaticInt(offset, index + 0x36, data, 5));
 		this->ACTIVEPANELOFFSETS.push_back(data[index + 0x5A]); // This is 0x10 in both versions I have, but who knows.
@@ -714,31 +992,29 @@ __int64 Memory::ReadStaticInt(__int64 offset, int index, const std::vector<byte>
 }
 
 uint64_t Memory::executeSigScan(const std::vector<byte>& signatureBytes, const SigScanDelegate& scanFunc, uint64_t startAddress) {
+	SigScanner scanner;
+	int id = scanner.add(signatureBytes, scanFunc);
+	executeSigScans(scanner, startAddress);
+	return scanner.result(id);
+}
+
+void Memory::executeSigScans(SigScanner& scanner, uint64_t startAddress) {
+	std::lock_guard<std::recursive_mutex> lock(_mtx);
+	if (!_image.loaded()) SnapshotImage();
+
 	std::vector<byte> scanBuffer;
 	scanBuffer.resize(SIGSCAN_STRIDE + SIGSCAN_PADDING); // padding in case the sigscan is past the end of the buffer
 
-	SIZE_T numBytesWritten;
 	for (uint64_t scanAddress = 0; scanAddress < PROGRAM_SIZE; scanAddress += SIGSCAN_STRIDE) {
-		if (!ReadProcessMemory(_handle, reinterpret_cast<void*>(scanAddress + startAddress), &scanBuffer[0], scanBuffer.size(), &numBytesWritten)) continue;
+		if (!ReadCode(scanAddress + startAddress, &scanBuffer[0], scanBuffer.size())) continue;
 
-		// Search for our target signature, testing our scan function against every match until we find a match or reach the end of our stride.
-		int searchLength = std::min(numBytesWritten, SIGSCAN_STRIDE + signatureBytes.size());
-		for (int matchIndex = 0; matchIndex < searchLength;) {
-			// Find the next instance of the signature.
-			matchIndex = Utilities::findSequence(scanBuffer, signatureBytes, matchIndex, searchLength);
-
-			if (matchIndex == -1) {
-				// We didn't find the signature in the remainder of this scan. Move to the next segment.
-				break;
-			}
-			// Test the scan function for a match. Note that the function is expecting an address relative to the starting address.
-			else if (scanFunc(scanAddress, matchIndex, scanBuffer)) {
-				return scanAddress + matchIndex;
-			}
-		}
+		// Matches that start in the padding are reported with the next segment instead. Note that the scan functions are expecting addresses relative to the starting address.
+		if (scanner.scan(scanAddress, scanBuffer, SIGSCAN_STRIDE)) break;
 	}
+}
 
-	return UINT64_MAX;
+void Memory::executeSigScans(SigScanner& scanner) {
+	executeSigScans(scanner, _baseAddress);
 }
 
 uint64_t Memory::executeSigScan(const std::vector<byte>& signatureBytes, const SigScanDelegate& scanFunc) {
@@ -753,6 +1029,23 @@ uint64_t Memory::executeSigScan(const std::vector<byte>& signatureBytes) {
 	return executeSigScan(signatureBytes, [](uint64_t offset, int index, const std::vector<byte>& data) { return true; });
 }
 
+// Try an access until it works, following retryPolicy. The attempts only keep the process from being swapped out under them; accesses
+//   from other threads go ahead at the same time.
+MemoryError Memory::Retry(const std::function<bool()>& attempt, bool retry) {
+	static thread_local std::minstd_rand jitter(std::random_device{}());
+	std::chrono::microseconds delay = retryPolicy.initialDelay;
+	for (int i = 0; ; i++) {
+		{
+			std::shared_lock<std::shared_mutex> lock(_attachMtx);
+			if (attempt()) return MemoryError::None;
+			if (!_backend->isAlive()) return MemoryError::ProcessExited;
+		}
+		if (!retry || !retryOnFail || i + 1 >= retryPolicy.maxAttempts) return MemoryError::Failed;
+		std::this_thread::sleep_for(delay / 2 + std::chrono::microseconds(jitter() % (delay.count() / 2 + 1)));
+		delay = std::min(delay * 2, retryPolicy.maxDelay);
+	}
+}
+
 void Memory::ThrowError(std::string message) {
 	if (!showMsg) {
 		if(errorWindow != NULL){
@@ -765,14 +1058,12 @@ void Memory::ThrowError(std::string message) {
 			std::string str_r(str);
 			SetWindowText(errorWindow, (L"Most recent error on " + std::wstring(str_r.begin(), str_r.end()) + L"\n" + std::wstring(message.begin(), message.end())).c_str());
 		}
-		throw std::exception(message.c_str());
+		throw MemoryException(_backend->isAlive() ? MemoryError::Failed : MemoryError::ProcessExited, message);
 	}
-	DWORD exitCode;
-	GetExitCodeProcess(_handle, &exitCode);
-	if (exitCode != STILL_ACTIVE) throw std::exception(message.c_str());
+	if (!_backend->isAlive()) throw MemoryException(MemoryError::ProcessExited, message);
 	message += "\nPlease close The Witness and try again. If the error persists, please report the issue on the Github Issues page.";
 	MessageBoxA(GetActiveWindow(), message.c_str(), NULL, MB_OK);
-	throw std::exception(message.c_str());
+	throw MemoryException(MemoryError::Failed, message);
 }
 
 void Memory::ThrowError(const std::vector<int>& offsets, bool rw_flag) {
@@ -799,6 +1090,27 @@ void Memory::ThrowError() {
 }
 
 void* Memory::ComputeOffset(std::vector<int> offsets)
+{
+	{
+		std::shared_lock<std::shared_mutex> lock(_cacheMtx);
+		void* address = nullptr;
+		if (CachedOffset(offsets, address)) return address;
+	}
+	return ResolveOffset(offsets);
+}
+
+bool Memory::CachedOffset(const std::vector<int>& offsets, void*& address) {
+	uintptr_t cumulativeAddress = _baseAddress;
+	for (size_t i = 0; i + 1 < offsets.size(); i++) {
+		const auto search = _computedAddresses.find(cumulativeAddress + offsets[i]);
+		if (search == std::end(_computedAddresses)) return false;
+		cumulativeAddress = search->second;
+	}
+	address = reinterpret_cast<void*>(cumulativeAddress + offsets.back());
+	return true;
+}
+
+void* Memory::ResolveOffset(std::vector<int> offsets)
 {
 	// Leave off the last offset, since it will be either read/write, and may not be of type unitptr_t.
 	int final_offset = offsets.back();
@@ -808,109 +1120,291 @@ void* Memory::ComputeOffset(std::vector<int> offsets)
 	for (const int offset : offsets) {
 		cumulativeAddress += offset;
 
-		const auto search = _computedAddresses.find(cumulativeAddress);
-		if (search == std::end(_computedAddresses)) {
-			// If the address is not yet computed, then compute it.
-			uintptr_t computedAddress = 0;
-			if (!ReadAbsolute(reinterpret_cast<LPVOID>(cumulativeAddress), &computedAddress, sizeof(uintptr_t))) {
-				ThrowError(offsets, false);
+		uintptr_t computedAddress = 0;
+		uint64_t generation;
+		{
+			std::shared_lock<std::shared_mutex> lock(_cacheMtx);
+			const auto search = _computedAddresses.find(cumulativeAddress);
+			generation = _cacheGeneration;
+			if (search != std::end(_computedAddresses)) {
+				cumulativeAddress = search->second;
+				continue;
 			}
-			_computedAddresses[cumulativeAddress] = computedAddress;
 		}
-
-		cumulativeAddress = _computedAddresses[cumulativeAddress];
+		// If the address is not yet computed, then compute it.
+		if (!ReadAbsolute(reinterpret_cast<LPVOID>(cumulativeAddress), &computedAddress, sizeof(uintptr_t))) {
+			ThrowError(offsets, false);
+		}
+		StoreAddress(generation, cumulativeAddress, computedAddress);
+		cumulativeAddress = computedAddress;
 	}
 	return reinterpret_cast<void*>(cumulativeAddress + final_offset);
 }
 
-void Memory::PowerNext(int source, int target) {
-	std::lock_guard<std::recursive_mutex> lock(mtx);
+// Another thread may have stored the same address while this one was reading it, which is fine, since they read the same pointer.
+void Memory::StoreAddress(uint64_t generation, uintptr_t address, uintptr_t value) {
+	std::unique_lock<std::shared_mutex> lock(_cacheMtx);
+	if (generation == _cacheGeneration) _computedAddresses[address] = value;
+}
 
-	uint64_t offset = reinterpret_cast<uintptr_t>(ComputeOffset({ GLOBALS, 0x18, source * 8, 0 }));
-	target += 1;
+uintptr_t Memory::GetPanelBase(int panel) {
+	size_t block = panel / PANEL_TABLE_BLOCK;
+	bool blockLoaded;
+	uint64_t generation;
+	{
+		// Empty entries are read again, in case the game has created the entity since
+		std::shared_lock<std::shared_mutex> lock(_cacheMtx);
+		blockLoaded = block < _panelBlockLoaded.size() && _panelBlockLoaded[block];
+		if (blockLoaded && _panelBases[panel] != 0) return _panelBases[panel];
+		generation = _cacheGeneration;
+	}
 
-	unsigned char buffer[] =
-		"\x48\xB8\x00\x00\x00\x00\x00\x00\x00\x00" //mov rax [address]
-		"\xB9\x00\x00\x00\x00" //mov ecx [address]
-		"\x48\xBA\x00\x00\x00\x00\x00\x00\x00\x00" //mov rdx [address]
-		"\x48\x83\xEC\x48" // sub rsp,48
-		"\xFF\xD0" //call rax
-		"\x48\x83\xC4\x48" // add rsp,48
-		"\xC3"; //ret
+	// The table is read without holding the cache lock, so that a slow or failing read doesn't hold up every other panel lookup
+	uintptr_t table = reinterpret_cast<uintptr_t>(ComputeOffset({ GLOBALS, 0x18, 0 }));
+	std::vector<uintptr_t> entries;
+	if (!blockLoaded) {
+		// The last block can run past the end of the table, in which case only the one entry is read
+		entries.resize(PANEL_TABLE_BLOCK);
+		if (!ReadOnce(table + block * PANEL_TABLE_BLOCK * sizeof(uintptr_t), &entries[0], PANEL_TABLE_BLOCK * sizeof(uintptr_t))) entries.clear();
+	}
+	uintptr_t base = entries.empty() ? 0 : entries[panel % PANEL_TABLE_BLOCK];
+	if (base == 0 && !ReadAbsolute(reinterpret_cast<LPCVOID>(table + panel * sizeof(uintptr_t)), &base, sizeof(uintptr_t)))
+		ThrowError({ GLOBALS, 0x18, panel * 8 }, false);
+
+	std::unique_lock<std::shared_mutex> lock(_cacheMtx);
+	if (generation != _cacheGeneration) return base; // The caches were cleared while reading, so what was read may be out of date
+	if (block >= _panelBlockLoaded.size()) {
+		_panelBlockLoaded.resize(block + 1, false);
+		_panelBases.resize((block + 1) * PANEL_TABLE_BLOCK, 0);
+	}
+	if (!entries.empty() && !_panelBlockLoaded[block]) {
+		for (size_t i = 0; i < PANEL_TABLE_BLOCK; i++) {
+			if (_panelBases[block * PANEL_TABLE_BLOCK + i] == 0) _panelBases[block * PANEL_TABLE_BLOCK + i] = entries[i];
+		}
+		_panelBlockLoaded[block] = true;
+	}
+	if (base != 0) _panelBases[panel] = base;
+	return base;
+}
 
-	buffer[2] = powerNextFunction & 0xff; //address of laser activation function
-	buffer[3] = (powerNextFunction >> 8) & 0xff;
-	buffer[4] = (powerNextFunction >> 16) & 0xff;
-	buffer[5] = (powerNextFunction >> 24) & 0xff;
-	buffer[6] = (powerNextFunction >> 32) & 0xff;
-	buffer[7] = (powerNextFunction >> 40) & 0xff;
-	buffer[8] = (powerNextFunction >> 48) & 0xff;
-	buffer[9] = (powerNextFunction >> 56) & 0xff;
-	buffer[11] = target & 0xff; //address of target
-	buffer[12] = (target >> 8) & 0xff;
-	buffer[13] = (target >> 16) & 0xff;
-	buffer[14] = (target >> 24) & 0xff;
-	buffer[17] = offset & 0xff; //address of source
-	buffer[18] = (offset >> 8) & 0xff;
-	buffer[19] = (offset >> 16) & 0xff;
-	buffer[20] = (offset >> 24) & 0xff;
-	buffer[21] = (offset >> 32) & 0xff;
-	buffer[22] = (offset >> 40) & 0xff;
-	buffer[23] = (offset >> 48) & 0xff;
-	buffer[24] = (offset >> 56) & 0xff;
-
-	SIZE_T allocation_size = sizeof(buffer);
-
-	LPVOID allocation_start = VirtualAllocEx(_handle, NULL, allocation_size, MEM_COMMIT | MEM_RESERVE, PAGE_EXECUTE_READWRITE);
-	WriteProcessMemory(_handle, allocation_start, buffer, allocation_size, NULL);
-	CreateRemoteThread(_handle, NULL, 0, (LPTHREAD_START_ROUTINE)allocation_start, NULL, 0, 0);
+void Memory::InvalidatePanel(int panel) {
+	PanelShard& shard = Shard(panel);
+	std::lock_guard<std::recursive_mutex> lock(shard.mtx);
+	shard.writes++; // Reads of the old entity that are still running mustn't store their bytes
+	shard.shadow.invalidate(panel);
+	std::unique_lock<std::shared_mutex> cacheLock(_cacheMtx);
+	_cacheGeneration++;
+	if (panel / PANEL_TABLE_BLOCK < _panelBlockLoaded.size()) _panelBases[panel] = 0;
+}
+
+bool Memory::ReadOnce(uintptr_t address, void* buffer, size_t size) {
+	return Retry([&]() { return _backend->read(address, buffer, size); }, false) == MemoryError::None;
+}
+
+// Address of the array that the pointer at the given panel offset points to. The array pointer is cached like in ComputeOffset.
+LPVOID Memory::ComputeArrayAddress(int panel, int offset) {
+	uintptr_t pointerAddress = GetPanelBase(panel) + offset;
+	uint64_t generation;
+	{
+		std::shared_lock<std::shared_mutex> lock(_cacheMtx);
+		const auto search = _computedAddresses.find(pointerAddress);
+		if (search != std::end(_computedAddresses)) return reinterpret_cast<LPVOID>(search->second);
+		generation = _cacheGeneration;
+	}
+	// The panel's shard is locked, so nothing else can be resolving the same array
+	uintptr_t arrayAddress = 0;
+	if (!ReadAbsolute(reinterpret_cast<LPCVOID>(pointerAddress), &arrayAddress, sizeof(uintptr_t)))
+		ThrowError({ GLOBALS, 0x18, panel * 8, offset }, false);
+	StoreAddress(generation, pointerAddress, arrayAddress);
+	return reinterpret_cast<LPVOID>(arrayAddress);
+}
+
+void Memory::ForgetArrayAddress(int panel, int offset) {
+	uintptr_t pointerAddress = GetPanelBase(panel) + offset;
+	std::unique_lock<std::shared_mutex> lock(_cacheMtx);
+	_computedAddresses.erase(pointerAddress);
+}
+
+PanelSnapshot Memory::ReadPanelSnapshot(int panel) {
+	PanelShard& shard = Shard(panel);
+	TracePanel trace(panel, 0);
+	uint64_t version = shard.writes;
+	PanelSnapshot snapshot;
+	snapshot.id = panel;
+	snapshot._base = GetPanelBase(panel);
+	bool ok = ReadAbsolute(reinterpret_cast<LPCVOID>(snapshot._base), &snapshot._data[0], PANEL_SNAPSHOT_SIZE);
+	StoreShadow(shard, version, ok, false, panel, 0, &snapshot._data[0], PANEL_SNAPSHOT_SIZE);
+	if (!ok) ThrowError({ GLOBALS, 0x18, panel * 8, 0 }, false);
+	return snapshot;
+}
+
+void Memory::ReadArrays(PanelSnapshot& snapshot) {
+	PanelShard& shard = Shard(snapshot.id);
+	TracePanel trace(snapshot.id, -1); // Several of the panel's arrays may be fetched with one read
+	uint64_t version = shard.writes;
+	std::vector<PanelSnapshot::ArrayRead>& arrays = snapshot._arrays;
+	// The array pointers are already in the snapshot, so they don't need to be read again
+	{
+		std::lock_guard<std::recursive_mutex> lock(shard.mtx);
+		std::unique_lock<std::shared_mutex> cacheLock(_cacheMtx);
+		for (PanelSnapshot::ArrayRead& array : arrays) {
+			array.address = snapshot.get<uintptr_t>(array.offset);
+			_computedAddresses[snapshot._base + array.offset] = array.address;
+			shard.arraySizes[std::make_pair(snapshot.id, array.offset)] = array.size;
+		}
+	}
+	std::sort(arrays.begin(), arrays.end(), [](const PanelSnapshot::ArrayRead& a, const PanelSnapshot::ArrayRead& b) { return a.address < b.address; });
+
+	for (size_t i = 0; i < arrays.size();) {
+		uintptr_t start = arrays[i].address;
+		uintptr_t end = start + arrays[i].bytes;
+		size_t j = i + 1;
+		while (start != 0 && j < arrays.size() && arrays[j].address <= end + PANEL_ARRAY_GAP) {
+			end = std::max(end, arrays[j].address + arrays[j].bytes);
+			j++;
+		}
+		bool loaded = false;
+		if (j - i > 1) {
+			std::vector<byte> buffer(end - start);
+			// The gap between two arrays may not be readable, in which case they are read one at a time
+			loaded = ReadOnce(start, &buffer[0], buffer.size());
+			if (loaded) {
+				for (size_t k = i; k < j; k++) std::memcpy(arrays[k].out, &buffer[arrays[k].address - start], arrays[k].bytes);
+			}
+		}
+		for (size_t k = i; k < j && !loaded; k++) {
+			if (!ReadAbsolute(reinterpret_cast<LPCVOID>(arrays[k].address), arrays[k].out, arrays[k].bytes))
+				ThrowError({ GLOBALS, 0x18, snapshot.id * 8, arrays[k].offset, 0 }, false);
+		}
+		i = j;
+	}
+	for (const PanelSnapshot::ArrayRead& array : arrays) StoreShadowArray(shard, version, true, false, snapshot.id, array.offset, array.out, array.bytes);
+	arrays.clear();
+}
+
+// Work out the address of a batch entry. Entries whose panel can't be found are left at address 0, which the backend skips.
+void Memory::ResolveRange(MemoryRange& range) {
+	range.ok = false;
+	if (range.panel == -1) return;
+	range.address = 0;
+	try {
+		uintptr_t base = GetPanelBase(range.panel);
+		if (base != 0) range.address = base + range.offset;
+	}
+	catch (std::exception&) {}
+}
+
+int Memory::ReadBatch(std::vector<MemoryRange>& ranges) {
+	std::vector<std::unique_lock<std::recursive_mutex>> shardLocks = LockShards(ranges);
+	for (MemoryRange& range : ranges) ResolveRange(range);
+	{
+		std::shared_lock<std::shared_mutex> attachLock(_attachMtx);
+		_backend->read(ranges);
+	}
+	for (const MemoryRange& range : ranges) {
+		if (range.ok && range.panel != -1) Shard(range.panel).shadow.store(range.panel, range.offset, range.buffer, range.size);
+	}
+	return static_cast<int>(std::count_if(ranges.begin(), ranges.end(), [](const MemoryRange& range) { return range.ok; }));
+}
+
+int Memory::WriteBatch(std::vector<MemoryRange>& ranges) {
+	std::vector<std::unique_lock<std::recursive_mutex>> shardLocks = LockShards(ranges);
+	// Ranges that wouldn't change anything count as written without being sent
+	std::vector<MemoryRange> changed;
+	std::vector<size_t> changedIndex;
+	for (size_t i = 0; i < ranges.size(); i++) {
+		MemoryRange& range = ranges[i];
+		range.ok = shadowWrites && range.panel != -1 && Shard(range.panel).shadow.matches(range.panel, range.offset, range.buffer, range.size);
+		if (range.ok) continue;
+		ResolveRange(range);
+		changed.push_back(range);
+		changedIndex.push_back(i);
+		// Reads of these panels running without the shard lock mustn't store what they saw before this write
+		if (range.panel != -1) Shard(range.panel).writes++;
+	}
+	{
+		std::shared_lock<std::shared_mutex> attachLock(_attachMtx);
+		_backend->write(changed);
+	}
+	for (size_t i = 0; i < changed.size(); i++) {
+		ranges[changedIndex[i]].ok = changed[i].ok;
+		if (changed[i].ok && changed[i].panel != -1) Shard(changed[i].panel).shadow.store(changed[i].panel, changed[i].offset, changed[i].buffer, changed[i].size);
+	}
+	return static_cast<int>(std::count_if(ranges.begin(), ranges.end(), [](const MemoryRange& range) { return range.ok; }));
+}
+
+void Memory::PowerNext(int source, int target) {
+	std::lock_guard<std::recursive_mutex> lock(_mtx);
+	QueueCall({ powerNextFunction, { static_cast<uint64_t>(target + 1), GetPanelBase(source) } });
 }
 
 void Memory::CallVoidFunction(int id, uint64_t functionAdress) {
-	std::lock_guard<std::recursive_mutex> lock(mtx);
+	std::lock_guard<std::recursive_mutex> lock(_mtx);
+	QueueCall({ functionAdress, { GetPanelBase(id) } });
+}
 
-	uint64_t offset = reinterpret_cast<uintptr_t>(ComputeOffset({ GLOBALS, 0x18, id * 8, 0 }));
+// The arena slot for a panel array that needs to hold bytes. The array keeps the slot it already has if that is big enough.
+//   A new slot isn't recorded until SettleArray is told the panel points at it, since the game still reads the old one until then.
+uintptr_t Memory::ReallocArray(int panel, int offset, size_t bytes) {
+	std::lock_guard<std::mutex> lock(_arenaMtx);
+	auto search = _arrayAllocations.find(std::make_pair(panel, offset));
+	if (search != _arrayAllocations.end() && _arena.capacity(search->second) >= bytes) return search->second;
+	return _arena.alloc(*_backend, bytes);
+}
 
-	unsigned char buffer[] =
-		"\x48\xB8\x00\x00\x00\x00\x00\x00\x00\x00" //mov rax [address]
-		"\x48\xB9\x00\x00\x00\x00\x00\x00\x00\x00" //mov rcx [address]
-		"\x48\x83\xEC\x48" // sub rsp,48
-		"\xFF\xD0" //call rax
-		"\x48\x83\xC4\x48" // add rsp,48
-		"\xC3"; //ret
+// Once the panel has been pointed at ptr, its old slot can be freed. If that write failed, the panel still uses the old slot, so ptr is freed instead.
+void Memory::SettleArray(int panel, int offset, uintptr_t ptr, bool pointed) {
+	std::lock_guard<std::mutex> lock(_arenaMtx);
+	auto key = std::make_pair(panel, offset);
+	auto search = _arrayAllocations.find(key);
+	uintptr_t old = search != _arrayAllocations.end() ? search->second : 0;
+	if (ptr == old) return;
+	if (!pointed) {
+		_arena.free(ptr);
+		return;
+	}
+	if (old) _arena.free(old);
+	_arrayAllocations[key] = ptr;
+}
 
-	buffer[2] = functionAdress & 0xff; //address of laser activation function
-	buffer[3] = (functionAdress >> 8) & 0xff;
-	buffer[4] = (functionAdress >> 16) & 0xff;
-	buffer[5] = (functionAdress >> 24) & 0xff;
-	buffer[6] = (functionAdress >> 32) & 0xff;
-	buffer[7] = (functionAdress >> 40) & 0xff;
-	buffer[8] = (functionAdress >> 48) & 0xff;
-	buffer[9] = (functionAdress >> 56) & 0xff;
-	buffer[12] = offset & 0xff; //address of laser
-	buffer[13] = (offset >> 8) & 0xff;
-	buffer[14] = (offset >> 16) & 0xff;
-	buffer[15] = (offset >> 24) & 0xff;
-	buffer[16] = (offset >> 32) & 0xff;
-	buffer[17] = (offset >> 40) & 0xff;
-	buffer[18] = (offset >> 48) & 0xff;
-	buffer[19] = (offset >> 56) & 0xff;
+// Calls are made straight away unless this thread has a batch open, in which case they wait for the end of the batch (or for it to fill up).
+//   Another thread's batch doesn't hold them up.
+void Memory::QueueCall(const RemoteCall& call) {
+	auto search = _callBatches.find(std::this_thread::get_id());
+	if (search == _callBatches.end()) {
+		_calls.queue(call);
+		_calls.flush(*_backend);
+		return;
+	}
+	search->second.calls.push_back(call);
+	if (search->second.calls.size() >= REMOTE_CALL_CAPACITY) FlushCallBatch(search->second);
+}
 
-	SIZE_T allocation_size = sizeof(buffer);
+void Memory::FlushCallBatch(CallBatch& batch) {
+	for (const RemoteCall& call : batch.calls) _calls.queue(call);
+	batch.calls.clear();
+	_calls.flush(*_backend);
+}
 
-	LPVOID allocation_start = VirtualAllocEx(_handle, NULL, allocation_size, MEM_COMMIT | MEM_RESERVE, PAGE_EXECUTE_READWRITE);
-	WriteProcessMemory(_handle, allocation_start, buffer, allocation_size, NULL);
-	HANDLE thread = CreateRemoteThread(_handle, NULL, 0, (LPTHREAD_START_ROUTINE)allocation_start, NULL, 0, 0);
+void Memory::BeginCallBatch() {
+	std::lock_guard<std::recursive_mutex> lock(_mtx);
+	_callBatches[std::this_thread::get_id()].depth++;
+}
 
-	WaitForSingleObject(thread, INFINITE);
+void Memory::EndCallBatch() {
+	std::lock_guard<std::recursive_mutex> lock(_mtx);
+	auto search = _callBatches.find(std::this_thread::get_id());
+	if (search == _callBatches.end() || --search->second.depth > 0) return;
+	FlushCallBatch(search->second);
+	_callBatches.erase(search);
 }
 
 void Memory::DisplayHudMessage(std::string message, std::array<float, 3> rgbColor) {
-	std::lock_guard<std::recursive_mutex> lock(mtx);
+	std::lock_guard<std::recursive_mutex> lock(_mtx);
 	char buffer[1024];
 
 	if (!_messageAddress) {
-		_messageAddress = VirtualAllocEx(_handle, NULL, sizeof(buffer), MEM_COMMIT | MEM_RESERVE, PAGE_READWRITE);
+		_messageAddress = _backend->alloc(sizeof(buffer), false);
 
 		__int64 address = hudTimePointer;
 		LPVOID addressPointer = reinterpret_cast<LPVOID>(address);
@@ -921,7 +1415,7 @@ void Memory::DisplayHudMessage(std::string message, std::array<float, 3> rgbColo
 
 	strcpy_s(buffer, message.c_str());
 
-	WriteProcessMemory(_handle, _messageAddress, buffer, sizeof(buffer), NULL);
+	_backend->write(_messageAddress, buffer, sizeof(buffer));
 
 	// Write the message's color values to the addresses of the constants we previously found.
 	const SIZE_T colorSize = sizeof(float);
@@ -930,7 +1424,7 @@ void Memory::DisplayHudMessage(std::string message, std::array<float, 3> rgbColo
 		void* writeAddress = reinterpret_cast<void*>(hudMessageColorAddresses[colorIndex]);
 		void* readAddress = reinterpret_cast<void*>(&rgbColor[colorIndex]);
 
-		WriteProcessMemory(_handle, writeAddress, readAddress, colorSize, NULL);
+		_backend->write(writeAddress, readAddress, colorSize);
 	}
 
 	__int64 funcAdress = displayHudFunction;
@@ -963,9 +1457,9 @@ void Memory::DisplayHudMessage(std::string message, std::array<float, 3> rgbColo
 
 	SIZE_T allocation_size = sizeof(asmBuff);
 
-	LPVOID allocation_start = VirtualAllocEx(_handle, NULL, allocation_size, MEM_COMMIT | MEM_RESERVE, PAGE_EXECUTE_READWRITE);
-	WriteProcessMemory(_handle, allocation_start, asmBuff, allocation_size, NULL);
-	CreateRemoteThread(_handle, NULL, 0, (LPTHREAD_START_ROUTINE)allocation_start, NULL, 0, 0);
+	LPVOID allocation_start = _backend->alloc(allocation_size, true);
+	_backend->write(allocation_start, asmBuff, allocation_size);
+	_backend->execute(allocation_start, false);
 }
 
 void Memory::DisplaySubtitles(std::string line1, std::string line2, std::string line3) {
@@ -976,11 +1470,11 @@ void Memory::DisplaySubtitles(std::string line1, std::string line2, std::string
 		__int32 oneBuff[1];
 		oneBuff[0] = 1;
 
-		WriteProcessMemory(_handle, reinterpret_cast<LPVOID>(addressOfSettings + 0xC), oneBuff, 4, NULL);
+		_backend->write(reinterpret_cast<LPVOID>(addressOfSettings + 0xC), oneBuff, 4);
 
 		std::this_thread::sleep_for(std::chrono::milliseconds(1000)); //Let the game load subtitles, if they are not loaded first the game crashes.
 
-		_subtitlesStuff = VirtualAllocEx(_handle, NULL, sizeof(buffer), MEM_COMMIT | MEM_RESERVE, PAGE_READWRITE);
+		_subtitlesStuff = _backend->alloc(sizeof(buffer), false);
 
 		std::string sectionName = "mitchell_ttc_11";
 
@@ -988,7 +1482,7 @@ void Memory::DisplaySubtitles(std::string line1, std::string line2, std::string
 
 		strcpy_s(buffer, sectionName.c_str());
 
-		WriteProcessMemory(_handle, _subtitlesStuff, buffer, sizeof(buffer), NULL);
+		_backend->write(_subtitlesStuff, buffer, sizeof(buffer));
 
 
 		char asmBuff1[] = // Make the game always play mitchell_ttc_11. This also skips the check whether an audio log is actually playing.
@@ -1009,7 +1503,7 @@ void Memory::DisplaySubtitles(std::string line1, std::string line2, std::string
 		__int64 address = displaySubtitlesFunction;
 		LPVOID addressPointer = reinterpret_cast<LPVOID>(address);
 
-		WriteProcessMemory(_handle, addressPointer, asmBuff1, sizeof(asmBuff1) - 1, NULL);
+		_backend->write(addressPointer, asmBuff1, sizeof(asmBuff1) - 1);
 
 
 		__int64 address2 = displaySubtitlesFunction2;
@@ -1019,7 +1513,7 @@ void Memory::DisplaySubtitles(std::string line1, std::string line2, std::string
 			"\xF3\x0F\x10\x0D\x92\x9A\x32\x00" // movss xmm1,dword ptr[1405134D0] (Which is 1.0f constant)
 			"\x90"; // nop
 
-		WriteProcessMemory(_handle, addressPointer2, asmBuff2, sizeof(asmBuff2) - 1, NULL);
+		_backend->write(addressPointer2, asmBuff2, sizeof(asmBuff2) - 1);
 
 		while (this->ReadData<__int64>({ (int) (this->subtitlesHashTable - _baseAddress) }, 1)[0] == 0) { // 0 means subtitles aren't loaded yet
 			std::this_thread::sleep_for(std::chrono::milliseconds(1000));
@@ -1085,31 +1579,28 @@ void Memory::DisplaySubtitles(std::string line1, std::string line2, std::string
 
 		SIZE_T allocation_size = sizeof(asmBuff3);
 
-		LPVOID allocation_start = VirtualAllocEx(_handle, NULL, allocation_size, MEM_COMMIT | MEM_RESERVE, PAGE_EXECUTE_READWRITE);
-		WriteProcessMemory(_handle, allocation_start, asmBuff3, allocation_size, NULL);
-		HANDLE thread = CreateRemoteThread(_handle, NULL, 0, (LPTHREAD_START_ROUTINE)allocation_start, NULL, 0, 0);
-
-		WaitForSingleObject(thread, INFINITE);
+		LPVOID allocation_start = _backend->alloc(allocation_size, true);
+		_backend->write(allocation_start, asmBuff3, allocation_size);
+		_backend->execute(allocation_start, true);
 
 		__int64 subtitleObjectPointer[1];
-		SIZE_T numBytesWritten;
-		ReadProcessMemory(_handle, reinterpret_cast<LPCVOID>(returnAddress), subtitleObjectPointer, 8, &numBytesWritten);
+		_backend->read(reinterpret_cast<LPCVOID>(returnAddress), subtitleObjectPointer, 8);
 
 		__int64 instantsPointer[1];
-		ReadProcessMemory(_handle, reinterpret_cast<LPCVOID>(subtitleObjectPointer[0] + 0x10), instantsPointer, 8, &numBytesWritten);
+		_backend->read(reinterpret_cast<LPCVOID>(subtitleObjectPointer[0] + 0x10), instantsPointer, 8);
 
 		__int64 instantsDataPointer[1];
-		ReadProcessMemory(_handle, reinterpret_cast<LPCVOID>(instantsPointer[0]), instantsDataPointer, 8, &numBytesWritten);
+		_backend->read(reinterpret_cast<LPCVOID>(instantsPointer[0]), instantsDataPointer, 8);
 
 		__int64 linesPointer[1];
-		ReadProcessMemory(_handle, reinterpret_cast<LPCVOID>(instantsDataPointer[0] + 0x8), linesPointer, 8, &numBytesWritten);
+		_backend->read(reinterpret_cast<LPCVOID>(instantsDataPointer[0] + 0x8), linesPointer, 8);
 
 		for (int i = 0; i < 3; i++) {
 			__int64 stringAddressBuffer[1];
 			stringAddressBuffer[0] = reinterpret_cast<__int64>(_subtitlesStuff) + (i + 1) * 0x100;
 
 
-			WriteProcessMemory(_handle, reinterpret_cast<LPVOID>(linesPointer[0] + i * 0x8), stringAddressBuffer, 8, &numBytesWritten);
+			_backend->write(reinterpret_cast<LPVOID>(linesPointer[0] + i * 0x8), stringAddressBuffer, 8);
 		}
 	}
 
@@ -1125,13 +1616,13 @@ void Memory::DisplaySubtitles(std::string line1, std::string line2, std::string
 	__int64 string2Address = reinterpret_cast<__int64>(_subtitlesStuff) + 0x200;
 	__int64 string3Address = reinterpret_cast<__int64>(_subtitlesStuff) + 0x300;
 
-	WriteProcessMemory(_handle, reinterpret_cast<LPVOID>(string1Address), line1buff, sizeof(line1buff), NULL);
-	WriteProcessMemory(_handle, reinterpret_cast<LPVOID>(string2Address), line2buff, sizeof(line2buff), NULL);
-	WriteProcessMemory(_handle, reinterpret_cast<LPVOID>(string3Address), line3buff, sizeof(line3buff), NULL);
+	_backend->write(reinterpret_cast<LPVOID>(string1Address), line1buff, sizeof(line1buff));
+	_backend->write(reinterpret_cast<LPVOID>(string2Address), line2buff, sizeof(line2buff));
+	_backend->write(reinterpret_cast<LPVOID>(string3Address), line3buff, sizeof(line3buff));
 }
 
 void Memory::RemoveMesh(int id) {
-	std::lock_guard<std::recursive_mutex> lock(mtx);
+	std::lock_guard<std::recursive_mutex> lock(Shard(id).mtx);
 	__int64 meshPointer = ReadPanelData<__int64>(id, 0x60); //Mesh
 	
 	__int64 buffer[1];
@@ -1149,7 +1640,7 @@ void Memory::MakeEPGlow(std::string name, std::vector<byte> patternPointBytes) {
 		buffer[0x200 + i] = name[i];
 	}
 
-	auto alloc = VirtualAllocEx(_handle, NULL, sizeof(buffer), MEM_COMMIT | MEM_RESERVE, PAGE_READWRITE);
+	auto alloc = _backend->alloc(sizeof(buffer), false);
 
 	u_int64 allocStart = reinterpret_cast<u_int64>(alloc);
 	u_int64 patternSolvedPart = allocStart + 0x100;
@@ -1175,7 +1666,7 @@ void Memory::MakeEPGlow(std::string name, std::vector<byte> patternPointBytes) {
 	buffer[0x10E] = (patternPointStart >> 48) & 0xff;
 	buffer[0x10F] = (patternPointStart >> 56) & 0xff;
 
-	WriteProcessMemory(_handle, alloc, buffer, sizeof(buffer), NULL);
+	_backend->write(alloc, buffer, sizeof(buffer));
 
 	/*unsigned char removeBuff[] =
 		"\x48\xB8\x00\x00\x00\x00\x00\x00\x00\x00" //mov rax [address]
@@ -1213,11 +1704,9 @@ void Memory::MakeEPGlow(std::string name, std::vector<byte> patternPointBytes) {
 
 	SIZE_T allocation_size = sizeof(removeBuff);
 
-	LPVOID allocation_start = VirtualAllocEx(_handle, NULL, allocation_size, MEM_COMMIT | MEM_RESERVE, PAGE_EXECUTE_READWRITE);
-	WriteProcessMemory(_handle, allocation_start, removeBuff, allocation_size, NULL);
-	HANDLE thread = CreateRemoteThread(_handle, NULL, 0, (LPTHREAD_START_ROUTINE)allocation_start, NULL, 0, 0);
-
-	WaitForSingleObject(thread, INFINITE);*/
+	LPVOID allocation_start = _backend->alloc(allocation_size, true);
+	_backend->write(allocation_start, removeBuff, allocation_size);
+	_backend->execute(allocation_start, true);*/
 
 
 
@@ -1266,14 +1755,18 @@ void Memory::MakeEPGlow(std::string name, std::vector<byte> patternPointBytes) {
 
 	SIZE_T allocation_size2 = sizeof(addBuff);
 
-	auto allocation_start2 = VirtualAllocEx(_handle, NULL, allocation_size2, MEM_COMMIT | MEM_RESERVE, PAGE_EXECUTE_READWRITE);
-	WriteProcessMemory(_handle, allocation_start2, addBuff, allocation_size2, NULL);
-	auto thread2 = CreateRemoteThread(_handle, NULL, 0, (LPTHREAD_START_ROUTINE)allocation_start2, NULL, 0, 0);
-
-	WaitForSingleObject(thread2, INFINITE);
+	auto allocation_start2 = _backend->alloc(allocation_size2, true);
+	_backend->write(allocation_start2, addBuff, allocation_size2);
+	_backend->execute(allocation_start2, true);
 }
 
-std::recursive_mutex Memory::mtx = std::recursive_mutex();
+std::shared_ptr<Memory> Memory::_session;
+std::mutex Memory::_sessionMtx;
+std::chrono::steady_clock::time_point Memory::_lastAliveCheck;
+bool Memory::_gameExited = false;
+std::string Memory::_recordPath;
+std::string Memory::_replayPath;
+ReplayMemoryBackend* Memory::_replay = nullptr;
 
 int Memory::GLOBALS = 0;
 int Memory::GAMELIB_RENDERER = 0;
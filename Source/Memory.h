@@ -6,28 +6,196 @@
 #include <sstream>
 #include <iomanip>
 #include <fstream>
+#include <memory>
+#include <mutex>
+#include <shared_mutex>
+#include <chrono>
+#include <array>
+#include <atomic>
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+#include <thread>
 
 #include "Archipelago\Client\apclientpp\apclient.hpp"
+#include "AddressCache.h"
+#include "MemoryBackend.h"
+#include "MemoryRecording.h"
+#include "MemoryTrace.h"
+#include "ModuleImage.h"
+#include "RemoteArena.h"
+#include "RemoteCallQueue.h"
+#include "ShadowCache.h"
+#include "SigScanner.h"
 #include <windows.h>
+#define PANEL_SNAPSHOT_SIZE 0x600 // Bytes of a panel's entity copied by ReadPanelSnapshot. Covers every panel offset in Randomizer.h.
+#define PANEL_SHARDS 16 // Panels are split into this many groups, each with its own lock.
+
+// A field of a panel's entity: count values of type T, stored in place at offset.
+template <class T>
+struct PanelField
+{
+	using Type = T;
+	int offset;
+	int count = 1;
+};
+
+// A pointer in a panel's entity to an array of T. The array holds perLength elements for each unit of the length field. Nullable arrays
+//   are only there on panels that use them, and have a null pointer otherwise.
+template <class T>
+struct PanelArrayField
+{
+	using Type = T;
+	int offset;
+	PanelField<int> length;
+	int perLength = 1;
+	bool nullable = false;
+
+	constexpr PanelField<uintptr_t> pointer() const { return { offset }; }
+	constexpr int size(int lengthValue) const { return lengthValue * perLength; }
+};
+
+// A local copy of a panel's entity, taken with a single read. Fields are decoded from the copy instead of being read one at a time,
+//   and the arrays it points to can be queued and then fetched together with Memory::ReadArrays.
+class PanelSnapshot
+{
+public:
+	int id = 0;
+
+	template <class T>
+	T get(int offset) const {
+		T value;
+		checkRange(offset, sizeof(T));
+		std::memcpy(&value, &_data[offset], sizeof(T));
+		return value;
+	}
+
+	template <class T>
+	std::vector<T> get(int offset, size_t size) const {
+		std::vector<T> data(size);
+		if (size == 0) return data;
+		checkRange(offset, sizeof(T) * size);
+		std::memcpy(&data[0], &_data[offset], sizeof(T) * size);
+		return data;
+	}
+
+	template <class T>
+	T get(const PanelField<T>& field) const {
+		return get<T>(field.offset);
+	}
+
+	template <class T>
+	std::vector<T> getAll(const PanelField<T>& field) const {
+		return get<T>(field.offset, field.count);
+	}
+
+	// Queue an array with the length the snapshot holds for it. A nullable array whose pointer is null comes back empty.
+	template <class T>
+	void queueArray(const PanelArrayField<T>& field, std::vector<T>& out) {
+		if (field.nullable && !get(field.pointer())) {
+			out.clear();
+			return;
+		}
+		queueArray(field.offset, field.size(get(field.length)), out);
+	}
+
+	// Queue the array pointed to by the field at offset. out is resized now, and filled in by the next Memory::ReadArrays.
+	template <class T>
+	void queueArray(int offset, int size, std::vector<T>& out) {
+		out.clear();
+		if (size <= 0) return;
+		out.resize(size);
+		_arrays.push_back({ offset, size, &out[0], sizeof(T) * size, 0 });
+	}
+
+private:
+	// Fields past PANEL_SNAPSHOT_SIZE weren't copied. Raise it to cover them, or read them with Memory::ReadPanelData instead.
+	void checkRange(int offset, size_t bytes) const {
+		if (offset < 0 || bytes > PANEL_SNAPSHOT_SIZE || static_cast<size_t>(offset) > PANEL_SNAPSHOT_SIZE - bytes)
+			throw std::out_of_range("Panel field " + std::to_string(offset) + " is outside the snapshot");
+	}
+
+	struct ArrayRead {
+		int offset;
+		int size;
+		void* out;
+		size_t bytes;
+		uintptr_t address;
+	};
+
+	std::array<byte, PANEL_SNAPSHOT_SIZE> _data = {};
+	std::vector<ArrayRead> _arrays;
+	uintptr_t _base = 0;
+
+	friend class Memory;
+};
+
+// Why a read or write of the game's memory failed.
+enum class MemoryError {
+	None,
+	Failed, // The memory still couldn't be accessed after retrying
+	ProcessExited, // The game was closed
+};
+
+// Thrown by the reads and writes that don't return a MemoryError.
+class MemoryException : public std::exception
+{
+public:
+	MemoryException(MemoryError error, const std::string& message) : std::exception(message.c_str()), error(error) {}
+	MemoryError error;
+};
+
+// How failed reads and writes are retried. The game's memory can be briefly unreadable while it loads, so a few retries are worth it,
+//   but each one waits twice as long as the last (up to maxDelay, with jitter), and retrying stops as soon as the game has exited.
+struct RetryPolicy
+{
+	int maxAttempts = 6;
+	std::chrono::microseconds initialDelay = std::chrono::microseconds(200);
+	std::chrono::microseconds maxDelay = std::chrono::microseconds(20000);
+};
+
 // https://github.com/erayarslan/WriteProcessMemory-Example
 // http://stackoverflow.com/q/32798185
 // http://stackoverflow.com/q/36018838
 // http://stackoverflow.com/q/1387064
 class Memory
 {
-private:
-	static std::recursive_mutex mtx;
-
 public:
 
 
 	Memory(const std::string& processName);
+	// Attach through the given backend instead of the one for this platform, for example a FakeMemoryBackend.
+	Memory(const std::string& processName, std::unique_ptr<MemoryBackend> backend);
+
+	// The process session shared by everything that reads or writes game memory. It attaches on first use, and tells the user if the game
+	//   isn't running. Once the game is closed, the session is detached and this throws from then on, since the addresses found at startup
+	//   don't fit a restarted game.
+	static std::shared_ptr<Memory> get();
+	// Replace the shared session, for example with a fake one for testing. Passing nullptr detaches it, so that the next get() attaches again,
+	//   even after the game was closed.
+	static void set(std::shared_ptr<Memory> memory);
+	// Log everything the shared session does with the game to the file at path, for ReplayMemoryBackend. Only takes effect if called before
+	//   the session first attaches.
+	static void recordTo(const std::string& path);
+	// Play the log at path back in place of the game for the shared session. Only takes effect if called before the session first attaches.
+	static void replayFrom(const std::string& path);
+	// How the shared session's replay has differed from its log so far. Empty if it isn't a replay.
+	static std::vector<std::string> replayDivergences();
+	bool IsProcessAlive();
+
 	int findGlobals();
-	void findGamelibRenderer();
-	void findMovementSpeed();
-	void findActivePanel();
-	void findPlayerPosition();
-	void findImportantFunctionAddresses();
+	// Find everything below in the game's code with a single pass over the executable, or load it from the cache if the executable hasn't changed.
+	//   Doesn't touch GLOBALS, so that it can run while candidates for it are tried.
+	void findAddresses();
+	// GLOBALS as cached for this executable, or 0. Remember it in the cache once it is known.
+	int LoadCachedGlobals();
+	void SaveGlobals();
+	// Register the signatures for one group of addresses. They are found once the scanner runs.
+	void findGamelibRenderer(SigScanner& scanner);
+	void findMovementSpeed(SigScanner& scanner);
+	void findActivePanel(SigScanner& scanner);
+	void findPlayerPosition(SigScanner& scanner);
+	void findImportantFunctionAddresses(SigScanner& scanner);
 	int GetActivePanel();
 	static __int64 ReadStaticInt(__int64 offset, int index, const std::vector<byte>& data, size_t bytesToEOL = 4);
 	~Memory();
@@ -37,8 +205,8 @@ public:
 
 	template <class T>
 	uintptr_t AllocArray(int id, int numItems) {
-		uintptr_t ptr = reinterpret_cast<uintptr_t>(VirtualAllocEx(_handle, 0, numItems * sizeof(T), MEM_COMMIT | MEM_RESERVE, PAGE_READWRITE));
-		return ptr;
+		std::lock_guard<std::mutex> lock(_arenaMtx);
+		return _arena.alloc(*_backend, numItems * sizeof(T));
 	}
 
 	template <class T>
@@ -46,8 +214,21 @@ public:
 		return AllocArray<T>(id, static_cast<int>(numItems));
 	}
 
+	// How much memory the arrays we've given panels take up in the game, and how often slots were reused.
+	RemoteArenaStats GetArenaStats() {
+		std::lock_guard<std::mutex> lock(_arenaMtx);
+		return _arena.stats();
+	}
+
+	// How many writes to panels were skipped because they wouldn't have changed anything.
+	ShadowCacheStats GetShadowStats();
+
 	LPVOID getHandle() {
-		return _handle;
+		return _backend->handle();
+	}
+
+	MemoryBackend* getBackend() {
+		return _backend.get();
 	}
 
 	uint64_t getBaseAddress() {
@@ -62,15 +243,12 @@ public:
 
 	// Reads data from memory at the specified address.
 	bool ReadAbsolute(LPCVOID lpBaseAddress, LPVOID lpBuffer, SIZE_T nSize) {
-		std::lock_guard<std::recursive_mutex> lock(mtx);
+		return TryReadAbsolute(lpBaseAddress, lpBuffer, nSize) == MemoryError::None;
+	}
 
-		if (!retryOnFail) return ReadProcessMemory(_handle, lpBaseAddress, lpBuffer, nSize, nullptr);
-		for (int i = 0; i < 10000; i++) {
-			if (ReadProcessMemory(_handle, lpBaseAddress, lpBuffer, nSize, nullptr)) {
-				return true;
-			}
-		}
-		return false;
+	// Like ReadAbsolute, but says why the read failed.
+	MemoryError TryReadAbsolute(LPCVOID lpBaseAddress, LPVOID lpBuffer, SIZE_T nSize) {
+		return Retry([&]() { return _backend->read(lpBaseAddress, lpBuffer, nSize); });
 	}
 
 	// Writes data to program memory relative to the base address of the program.
@@ -81,75 +259,235 @@ public:
 
 	// Writes data to memory at the specified address.
 	bool WriteAbsolute(LPVOID lpBaseAddress, LPCVOID lpBuffer, SIZE_T nSize) {
-		std::lock_guard<std::recursive_mutex> lock(mtx);
+		return TryWriteAbsolute(lpBaseAddress, lpBuffer, nSize) == MemoryError::None;
+	}
 
-		if (!retryOnFail) return WriteProcessMemory(_handle, lpBaseAddress, lpBuffer, nSize, nullptr);
-		for (int i = 0; i < 10000; i++) {
-			if (WriteProcessMemory(_handle, lpBaseAddress, lpBuffer, nSize, nullptr)) {
-				return true;
-			}
-		}
-		return false;
+	// Like WriteAbsolute, but says why the write failed.
+	MemoryError TryWriteAbsolute(LPVOID lpBaseAddress, LPCVOID lpBuffer, SIZE_T nSize) {
+		return Retry([&]() { return _backend->write(lpBaseAddress, lpBuffer, nSize); });
 	}
 
 	template <class T>
 	std::vector<T> ReadArray(int panel, int offset, int size) {
-		std::lock_guard<std::recursive_mutex> lock(mtx);
+		PanelShard& shard = Shard(panel);
+		TracePanel trace(panel, offset);
 		if (size == 0) return std::vector<T>();
-		if (offset == 0x230 || offset == 0x238) { //Traced edge data - this moves sometimes so it should not be cached
-			//Invalidate cache entry for old array address
-			_computedAddresses.erase(reinterpret_cast<uintptr_t>(ComputeOffset({ GLOBALS, 0x18, panel * 8, offset })));
+		LPVOID address;
+		uint64_t version = shard.writes;
+		{
+			std::lock_guard<std::recursive_mutex> lock(shard.mtx);
+			if (offset == 0x230 || offset == 0x238) { //Traced edge data - this moves sometimes so it should not be cached
+				//Invalidate cache entry for old array address
+				ForgetArrayAddress(panel, offset);
+			}
+			shard.arraySizes[std::make_pair(panel, offset)] = size;
+			address = ComputeArrayAddress(panel, offset);
 		}
-		_arraySizes[std::make_pair(panel, offset)] = size;
-		return ReadData<T>({ GLOBALS, 0x18, panel * 8, offset, 0 }, size);
+		std::vector<T> data(size);
+		bool ok = ReadAbsolute(address, &data[0], sizeof(T) * size);
+		StoreShadowArray(shard, version, ok, false, panel, offset, &data[0], sizeof(T) * size);
+		if (!ok) ThrowError({ GLOBALS, 0x18, panel * 8, offset, 0 }, false);
+		return data;
 	}
 
 	template <class T>
 	void WriteArray(int panel, int offset, const std::vector<T>& data) {
-		std::lock_guard<std::recursive_mutex> lock(mtx);
+		PanelShard& shard = Shard(panel);
+		TracePanel trace(panel, offset);
 		if (data.size() == 0) return;
-		if (data.size() > _arraySizes[std::make_pair(panel, offset)]) {
-			//Invalidate cache entry for old array address
-			_computedAddresses.erase(reinterpret_cast<uintptr_t>(ComputeOffset({ GLOBALS, 0x18, panel * 8, offset })));
-			//Allocate new array in process memory
-			uintptr_t ptr = AllocArray<T>(panel, data.size());
-			WritePanelData<uintptr_t>(panel, offset, { ptr });
+		LPVOID address;
+		uint64_t version;
+		{
+			// Growing the array stays under the lock, so that two threads don't both reallocate it
+			std::lock_guard<std::recursive_mutex> lock(shard.mtx);
+			if (data.size() > shard.arraySizes[std::make_pair(panel, offset)]) {
+				//Invalidate cache entry for old array address
+				ForgetArrayAddress(panel, offset);
+				//Allocate new array in process memory
+				uintptr_t ptr = ReallocArray(panel, offset, sizeof(T) * data.size());
+				try {
+					write<uintptr_t>(panel, offset, ptr);
+				}
+				catch (...) {
+					SettleArray(panel, offset, ptr, false);
+					throw;
+				}
+				SettleArray(panel, offset, ptr, true);
+				shard.arraySizes[std::make_pair(panel, offset)] = static_cast<int>(data.size());
+			}
+			else if (shadowWrites && shard.shadow.matchesArray(panel, offset, &data[0], sizeof(T) * data.size())) return;
+			address = ComputeArrayAddress(panel, offset);
+			version = ++shard.writes;
 		}
-		WriteData<T>({ GLOBALS, 0x18, panel * 8, offset, 0 }, data);
+		bool ok = WriteAbsolute(address, &data[0], sizeof(T) * data.size());
+		StoreShadowArray(shard, version, ok, true, panel, offset, &data[0], sizeof(T) * data.size());
+		if (!ok) ThrowError({ GLOBALS, 0x18, panel * 8, offset, 0 }, true);
 	}
 
 	template <class T>
 	void WriteArray(int panel, int offset, const std::vector<T>& data, bool force) {
-		std::lock_guard<std::recursive_mutex> lock(mtx);
-		if (force) _arraySizes[std::make_pair(panel, offset)] = 0;
+		if (force) {
+			// Forgetting the size makes the write below move the array to a slot of our own
+			PanelShard& shard = Shard(panel);
+			std::lock_guard<std::recursive_mutex> lock(shard.mtx);
+			shard.arraySizes[std::make_pair(panel, offset)] = 0;
+		}
 		WriteArray(panel, offset, data);
 	}
 
+	// Read an array with the length the game holds for it. A nullable array whose pointer is null comes back empty.
+	template <class T>
+	std::vector<T> ReadArray(int panel, const PanelArrayField<T>& field) {
+		if (field.nullable && !read(panel, field.pointer())) return std::vector<T>();
+		return ReadArray<T>(panel, field.offset, field.size(read(panel, field.length)));
+	}
+
+	template <class T>
+	void WriteArray(int panel, const PanelArrayField<T>& field, const std::vector<T>& data) {
+		WriteArray(panel, field.offset, data);
+	}
+
 	template <class T>
 	std::vector<T> ReadPanelData(int panel, int offset, size_t size) {
+		PanelShard& shard = Shard(panel);
+		TracePanel trace(panel, offset);
 		if (size == 0) return std::vector<T>();
-		return ReadData<T>({ GLOBALS, 0x18, panel * 8, offset }, size);
+		uint64_t version = shard.writes;
+		std::vector<T> data(size);
+		bool ok = ReadAbsolute(reinterpret_cast<LPCVOID>(GetPanelBase(panel) + offset), &data[0], sizeof(T) * size);
+		StoreShadow(shard, version, ok, false, panel, offset, &data[0], sizeof(T) * size);
+		if (!ok) ThrowError({ GLOBALS, 0x18, panel * 8, offset }, false);
+		return data;
 	}
 
 	template <class T>
 	T ReadPanelData(int panel, int offset) {
-		std::vector<T> result = ReadData<T>({ GLOBALS, 0x18, panel * 8, offset }, 1);
+		return read<T>(panel, offset);
+	}
 
-		if (result.size() == 0) {
-			std::exception e;
-			throw e;
-		}
+	template <class T>
+	std::vector<T> ReadPanelData(int panel, const PanelField<T>& field) {
+		return ReadPanelData<T>(panel, field.offset, field.count);
+	}
 
-		return result[0];
+	template <class T>
+	void WritePanelData(int panel, const PanelField<T>& field, const std::vector<T>& data) {
+		WritePanelData(panel, field.offset, data);
 	}
 
 	template <class T>
 	void WritePanelData(int panel, int offset, const std::vector<T>& data) {
-		WriteData<T>({ GLOBALS, 0x18, panel * 8, offset }, data);
+		PanelShard& shard = Shard(panel);
+		TracePanel trace(panel, offset);
+		if (data.empty()) return;
+		uint64_t version = BeginShadowWrite(shard, panel, offset, &data[0], sizeof(T) * data.size());
+		if (!version) return;
+		bool ok = WriteAbsolute(reinterpret_cast<LPVOID>(GetPanelBase(panel) + offset), &data[0], sizeof(T) * data.size());
+		StoreShadow(shard, version, ok, true, panel, offset, &data[0], sizeof(T) * data.size());
+		if (!ok) ThrowError({ GLOBALS, 0x18, panel * 8, offset }, true);
+	}
+
+	// Copy a whole panel entity with one read.
+	PanelSnapshot ReadPanelSnapshot(int panel);
+	// Read every array queued on the snapshot. Arrays that lie close together in the game's memory are fetched with a single read.
+	void ReadArrays(PanelSnapshot& snapshot);
+
+	// Read or write every range in one locked pass. Each range is tried once; one that fails doesn't stop the others, and doesn't throw. Returns the number of ranges that succeeded.
+	int ReadBatch(std::vector<MemoryRange>& ranges);
+	int WriteBatch(std::vector<MemoryRange>& ranges);
+
+	// Read the same field from each of the given panels in one pass, size items per panel. Panels that can't be read give T(). If ok is given,
+	//   it is set to whether each panel was read.
+	template <class T>
+	std::vector<T> ReadPanelBatch(const std::vector<int>& panels, int offset, size_t size = 1, std::vector<bool>* ok = nullptr) {
+		std::vector<T> data(panels.size() * size);
+		std::vector<MemoryRange> ranges;
+		ranges.reserve(panels.size());
+		for (size_t i = 0; i < panels.size(); i++) ranges.emplace_back(panels[i], offset, sizeof(T) * size, &data[i * size]);
+		ReadBatch(ranges);
+		if (ok) ok->assign(panels.size(), false);
+		for (size_t i = 0; i < panels.size(); i++) {
+			if (!ranges[i].ok) std::fill(data.begin() + i * size, data.begin() + (i + 1) * size, T());
+			else if (ok) (*ok)[i] = true;
+		}
+		return data;
+	}
+
+	template <class T>
+	std::vector<T> ReadPanelBatch(const std::vector<int>& panels, const PanelField<T>& field, std::vector<bool>* ok = nullptr) {
+		return ReadPanelBatch<T>(panels, field.offset, field.count, ok);
+	}
+
+	// Write the same field of each of the given panels in one pass.
+	template <class T>
+	void WritePanelBatch(const std::vector<int>& panels, int offset, const std::vector<T>& data) {
+		if (data.empty()) return;
+		std::vector<MemoryRange> ranges;
+		ranges.reserve(panels.size());
+		for (int panel : panels) ranges.emplace_back(panel, offset, sizeof(T) * data.size(), const_cast<T*>(&data[0]));
+		WriteBatch(ranges);
+	}
+
+	// Read a single field of a panel. Doesn't allocate.
+	template <class T>
+	T read(int panel, int offset) {
+		PanelShard& shard = Shard(panel);
+		TracePanel trace(panel, offset);
+		uint64_t version = shard.writes;
+		T value;
+		bool ok = ReadAbsolute(reinterpret_cast<LPCVOID>(GetPanelBase(panel) + offset), &value, sizeof(T));
+		StoreShadow(shard, version, ok, false, panel, offset, &value, sizeof(T));
+		if (!ok) ThrowError({ GLOBALS, 0x18, panel * 8, offset }, false);
+		return value;
+	}
+
+	template <class T>
+	T read(int panel, const PanelField<T>& field) {
+		return read<T>(panel, field.offset);
 	}
 
+	// Read a single field of a panel without throwing, for pollers that can just try again later. value is only set if the read worked.
+	template <class T>
+	MemoryError TryReadPanelData(int panel, int offset, T& value) {
+		PanelShard& shard = Shard(panel);
+		TracePanel trace(panel, offset);
+		uint64_t version = shard.writes;
+		uintptr_t base = 0;
+		try {
+			base = GetPanelBase(panel);
+		}
+		catch (MemoryException& e) {
+			return e.error;
+		}
+		MemoryError error = TryReadAbsolute(reinterpret_cast<LPCVOID>(base + offset), &value, sizeof(T));
+		StoreShadow(shard, version, error == MemoryError::None, false, panel, offset, &value, sizeof(T));
+		return error;
+	}
+
+	// Write a single field of a panel. Doesn't allocate.
+	template <class T>
+	void write(int panel, int offset, const T& value) {
+		PanelShard& shard = Shard(panel);
+		TracePanel trace(panel, offset);
+		uint64_t version = BeginShadowWrite(shard, panel, offset, &value, sizeof(T));
+		if (!version) return;
+		bool ok = WriteAbsolute(reinterpret_cast<LPVOID>(GetPanelBase(panel) + offset), &value, sizeof(T));
+		StoreShadow(shard, version, ok, true, panel, offset, &value, sizeof(T));
+		if (!ok) ThrowError({ GLOBALS, 0x18, panel * 8, offset }, true);
+	}
+
+	template <class T>
+	void write(int panel, const PanelField<T>& field, const T& value) {
+		write<T>(panel, field.offset, value);
+	}
+
+	// Address of a panel's entity in the game's memory. The game's panel pointer table is read a block at a time and cached.
+	uintptr_t GetPanelBase(int panel);
+	// Forget the cached address of a panel and the shadow copy of its fields, for when the game replaces its entity.
+	void InvalidatePanel(int panel);
+
 	void WriteMovementSpeed(float speed) {
-		std::lock_guard<std::recursive_mutex> lock(mtx);
+		std::lock_guard<std::recursive_mutex> lock(_mtx);
 		if (speed == 0) return;
 		float sprintSpeed = this->ReadData<float>({ RUNSPEED }, 1)[0];
 		if (sprintSpeed == 0.0f) return; // sanity check, to avoid an accidental div0
@@ -178,6 +516,12 @@ public:
 
 	void PowerNext(int source, int target);
 
+	// Remote calls (OpenDoor, InitPanel, PowerNext, ...) made between these are run together on one thread in the game, when the outermost
+	//   batch ends. Only for calls that don't depend on reads or writes made in between, since those still happen straight away.
+	// Batches belong to the thread that opens them. Calls from other threads are made straight away.
+	void BeginCallBatch();
+	void EndCallBatch();
+
 	void UpdateEntityPosition(int id) {
 		CallVoidFunction(id, updateEntityPositionFunction); // Entity::has_moved_in_a_non_position_way - Still works even if it HAS moved in a non position way, for some reason :P
 	}
@@ -232,8 +576,9 @@ public:
 	// Caches values for quick lookup.
 	void* ComputeOffset(std::vector<int> offsets);
 
-	// Clear cached offsets computed by ComputeOffset.
-	void ClearOffsets() { _computedAddresses = std::map<uintptr_t, uintptr_t>(); }
+	// Clear cached offsets computed by ComputeOffset, the cached panel addresses and the shadow copy of panel fields. Call this when the
+	//   game reloads.
+	void ClearOffsets();
 
 	static int GLOBALS;
 	static int GAMELIB_RENDERER;
@@ -284,6 +629,13 @@ public:
 	static int globalsTests[3];
 	static HWND errorWindow;
 	bool retryOnFail = true;
+	// Take the scan results from ADDRESS_CACHE_FILE when it matches the executable. Off for recorded and replayed sessions.
+	bool useAddressCache = true;
+	RetryPolicy retryPolicy;
+	// Skip writes to panel fields and arrays that would leave them as they were last read or written. Fields the game changes on its own
+	//   are always written. Off by default: nothing notices the game loading a save, which can reset other fields behind the shadow's back,
+	//   so only turn it on where ClearOffsets or InvalidatePanel is called after anything that could.
+	bool shadowWrites = false;
 
 	// Scan the process's memory for the given signature, returning the address of the first byte of the signature relative to startAddress if found,
 	//   or UINT64_MAX if not.
@@ -294,11 +646,18 @@ public:
 	uint64_t executeSigScan(const std::vector<byte>& signatureBytes, const SigScanDelegate& scanFunc);
 	uint64_t executeSigScan(const std::vector<byte>& signatureBytes, uint64_t startAddress);
 	uint64_t executeSigScan(const std::vector<byte>& signatureBytes);
+	// Run every signature registered with scanner in one pass over the process's memory. Offsets passed to the callbacks and stored as results
+	//   are relative to startAddress, or to _baseAddress if it isn't provided.
+	void executeSigScans(SigScanner& scanner, uint64_t startAddress);
+	void executeSigScans(SigScanner& scanner);
+	// Copy the game's executable into memory, so that signature scans and code reads are served locally. Scans take the snapshot on their
+	//   own if there isn't one yet. Returns false if the executable's headers can't be read, in which case everything reads from the process.
+	// Scans, patches and the snapshot take _mtx, since they may run on any thread while Detach replaces the snapshot.
+	bool SnapshotImage();
 
 private:
 	template<class T>
 	std::vector<T> ReadData(const std::vector<int>& offsets, size_t numItems) {
-		std::lock_guard<std::recursive_mutex> lock(mtx);
 		std::vector<T> data;
 		data.resize(numItems);
 		if (ReadAbsolute(ComputeOffset(offsets), &data[0], sizeof(T) * numItems)) {
@@ -310,7 +669,6 @@ private:
 
 	template <class T>
 	void WriteData(const std::vector<int>& offsets, const std::vector<T>& data) {
-		std::lock_guard<std::recursive_mutex> lock(mtx);
 		if (WriteAbsolute(ComputeOffset(offsets), &data[0], sizeof(T) * data.size())) {
 			return;
 		}
@@ -323,16 +681,108 @@ private:
 	void ThrowError(const std::vector<int>& offsets, bool rw_flag);
 	void ThrowError();
 
+	void ResolveRange(MemoryRange& range);
+	// Tries once if retry is false, even if retryOnFail is set.
+	MemoryError Retry(const std::function<bool()>& attempt, bool retry = true);
+	bool ReadOnce(uintptr_t address, void* buffer, size_t size);
+
+	// Change the game's code while scanning. Patches are remembered so that they can be made again when the scan is skipped.
+	bool Patch(uint64_t address, const void* bytes, size_t size);
+	// Read the game's code or constants, from the snapshot if it has them. Writable data isn't in the snapshot, so it is read from the process,
+	//   but ReadData or ReadAbsolute say better that the value can change.
+	bool ReadCode(uint64_t address, void* buffer, size_t size);
+	uint64_t GetExecutableFingerprint();
+	bool LoadAddresses(const AddressCache& cache);
+	AddressCache SaveAddresses(uint64_t fingerprint);
+
 	void CallVoidFunction(int id, uint64_t functionAdress);
+	void QueueCall(const RemoteCall& call);
+	// The calls one thread has made in its open batch.
+	struct CallBatch {
+		int depth = 0;
+		std::vector<RemoteCall> calls;
+	};
+	void FlushCallBatch(CallBatch& batch);
+	uintptr_t ReallocArray(int panel, int offset, size_t bytes);
+	void SettleArray(int panel, int offset, uintptr_t ptr, bool pointed);
+	LPVOID ComputeArrayAddress(int panel, int offset);
+	void ForgetArrayAddress(int panel, int offset);
+	// ComputeOffset, one pointer at a time. The pointers are read without holding _cacheMtx. CachedOffset only needs it shared, and fails
+	//   if anything would have to be read.
+	void* ResolveOffset(std::vector<int> offsets);
+	bool CachedOffset(const std::vector<int>& offsets, void*& address);
+	// Cache a pointer read since the caches were at generation, unless they have been cleared since.
+	void StoreAddress(uint64_t generation, uintptr_t address, uintptr_t value);
+
+	void Attach();
+	void Detach();
+
+	// Everything about the panels whose ids fall in one shard. Threads working on panels in different shards don't wait for each other.
+	// Panel reads and writes talk to the game without holding mtx, so that a retry's backoff doesn't hold up the other threads on the shard.
+	//   writes counts the writes started on the shard: a read or write only puts its bytes in the shadow if no other write started while it
+	//   ran, and a write that raced another forgets them, so the shadow never holds bytes the game may not have.
+	struct PanelShard {
+		std::recursive_mutex mtx;
+		ShadowCache shadow;
+		std::map<std::pair<int, int>, int> arraySizes;
+		std::atomic<uint64_t> writes = 0;
+	};
+	PanelShard& Shard(int panel) { return _shards[static_cast<unsigned>(panel) % PANEL_SHARDS]; }
+	// Lock the shards of every panel in ranges, or every shard, in index order.
+	std::vector<std::unique_lock<std::recursive_mutex>> LockShards(const std::vector<MemoryRange>& ranges);
+	std::vector<std::unique_lock<std::recursive_mutex>> LockShards();
+	// Returns 0 if the write can be skipped, or the version to pass to StoreShadow once it is made.
+	uint64_t BeginShadowWrite(PanelShard& shard, int panel, int offset, const void* data, size_t size);
+	// Record the outcome of a read or write made since the shard was at version.
+	void StoreShadow(PanelShard& shard, uint64_t version, bool ok, bool write, int panel, int offset, const void* data, size_t size);
+	void StoreShadowArray(PanelShard& shard, uint64_t version, bool ok, bool write, int panel, int offset, const void* data, size_t size);
+
+	static std::shared_ptr<Memory> _session;
+	static std::mutex _sessionMtx;
+	static std::chrono::steady_clock::time_point _lastAliveCheck;
+	static bool _gameExited; // The session's game was closed
+	static std::string _recordPath; // Empty unless the session is recorded
+	static std::string _replayPath; // Empty unless the session is replayed
+	static ReplayMemoryBackend* _replay; // The session's backend, if it is a replay
+
+	// Locks, outermost first. A thread holding one of them only takes the ones after it.
+	std::recursive_mutex _mtx; // Remote calls, code patches and scans, and attaching to the game
+	std::array<PanelShard, PANEL_SHARDS> _shards;
+	std::shared_mutex _cacheMtx; // _computedAddresses and the panel addresses. Lookups share it, only storing what was read takes it exclusively.
+	std::mutex _arenaMtx; // _arena and _arrayAllocations
+	std::shared_mutex _attachMtx; // Shared by every call into the backend, and taken exclusively while the process is swapped out
 
 	std::map<uintptr_t, uintptr_t> _computedAddresses;
-	std::map<std::pair<int, int>, int> _arraySizes;
+	std::vector<uintptr_t> _panelBases; // Indexed by panel id
+	std::vector<bool> _panelBlockLoaded; // Which blocks of _panelBases have been read from the game
+	uint64_t _cacheGeneration = 0; // Bumped whenever the caches above are cleared, so that pointers read before then aren't stored
 	LPVOID _messageAddress = 0;
 	LPVOID _subtitlesStuff = 0;
-	HANDLE _handle = nullptr;
+	std::unique_ptr<MemoryBackend> _backend;
+	std::string _processName;
+	std::vector<AddressCache::Bytes> _patches; // Made by the last scan, relative to _baseAddress
+	ModuleImage _image; // The executable's read-only sections as of the first scan, plus the patches made while scanning. Guarded by _mtx.
+	RemoteCallQueue _calls;
+	std::map<std::thread::id, CallBatch> _callBatches; // Open batches, by the thread that opened them
+	RemoteArena _arena;
+	std::map<std::pair<int, int>, uintptr_t> _arrayAllocations; // Arena slot each panel array we replaced points to
 
 	uintptr_t _baseAddress = 0;
 
 	friend class Randomizer;
 	friend class Special;
+};
+
+// Batches every remote call made through memory while it is in scope.
+class RemoteCallBatch
+{
+public:
+	RemoteCallBatch(const std::shared_ptr<Memory>& memory) : _memory(memory) { _memory->BeginCallBatch(); }
+	~RemoteCallBatch() { _memory->EndCallBatch(); }
+
+	RemoteCallBatch(const RemoteCallBatch&) = delete;
+	RemoteCallBatch& operator=(const RemoteCallBatch&) = delete;
+
+private:
+	std::shared_ptr<Memory> _memory;
 };
\ No newline at end of file
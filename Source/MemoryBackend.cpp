@@ -0,0 +1,304 @@
+// This is an open source non-commercial project. Dear PVS-Studio, please check it.
+
+// PVS-Studio Static Code Analyzer for C, C++, C#, and Java: http://www.viva64.com
+
+#include "MemoryBackend.h"
+#include <algorithm>
+#include <cstring>
+
+#ifdef _WIN32
+#include <windows.h>
+#include <psapi.h>
+#include <tlhelp32.h>
+
+#undef PROCESSENTRY32
+#undef Process32First
+#undef Process32Next
+#endif
+
+#ifdef __linux__
+#include <dirent.h>
+#include <fcntl.h>
+#include <signal.h>
+#include <sys/uio.h>
+#include <unistd.h>
+#include <cerrno>
+#include <fstream>
+#include <sstream>
+#endif
+
+#define LINUX_MAX_IOVECS 1024 // Most ranges passed to one process_vm_readv call (IOV_MAX)
+
+std::unique_ptr<MemoryBackend> MemoryBackend::create() {
+#ifdef _WIN32
+	return std::make_unique<Win32MemoryBackend>();
+#elif defined(__linux__)
+	return std::make_unique<LinuxMemoryBackend>();
+#else
+	return std::make_unique<FakeMemoryBackend>();
+#endif
+}
+
+void MemoryBackend::read(std::vector<MemoryRange>& ranges) {
+	for (MemoryRange& range : ranges) {
+		range.ok = range.address != 0 && read(range.address, range.buffer, range.size);
+	}
+}
+
+void MemoryBackend::write(std::vector<MemoryRange>& ranges) {
+	for (MemoryRange& range : ranges) {
+		range.ok = range.address != 0 && write(range.address, range.buffer, range.size);
+	}
+}
+
+#ifdef _WIN32
+
+Win32MemoryBackend::~Win32MemoryBackend() {
+	close();
+}
+
+// Calls func with each running process until it returns true
+static void forEachProcess(const std::function<bool(const PROCESSENTRY32& entry)>& func) {
+	PROCESSENTRY32 entry;
+	entry.dwSize = sizeof(entry);
+	HANDLE snapshot = CreateToolhelp32Snapshot(TH32CS_SNAPPROCESS, 0);
+	if (snapshot == INVALID_HANDLE_VALUE) return;
+	for (BOOL more = Process32First(snapshot, &entry); more; more = Process32Next(snapshot, &entry)) {
+		if (func(entry)) break;
+	}
+	CloseHandle(snapshot);
+}
+
+bool Win32MemoryBackend::open(const std::string& processName) {
+	close();
+	forEachProcess([&](const PROCESSENTRY32& entry) {
+		if (processName != entry.szExeFile) return false;
+		_handle = OpenProcess(PROCESS_ALL_ACCESS, FALSE, entry.th32ProcessID);
+		return true;
+	});
+	return _handle != nullptr;
+}
+
+void Win32MemoryBackend::close() {
+	if (_handle) CloseHandle(_handle);
+	_handle = nullptr;
+}
+
+bool Win32MemoryBackend::isRunning(const std::string& processName) {
+	bool found = false;
+	forEachProcess([&](const PROCESSENTRY32& entry) {
+		found = processName == entry.szExeFile;
+		return found;
+	});
+	return found;
+}
+
+bool Win32MemoryBackend::isAlive() {
+	return _handle && WaitForSingleObject(_handle, 0) == WAIT_TIMEOUT;
+}
+
+uintptr_t Win32MemoryBackend::moduleBase(const std::string& moduleName) {
+	DWORD numModules = 0;
+	std::vector<HMODULE> moduleList(1024);
+	if (!EnumProcessModulesEx(_handle, &moduleList[0], static_cast<DWORD>(moduleList.size() * sizeof(HMODULE)), &numModules, LIST_MODULES_ALL)) return 0;
+
+	for (DWORD i = 0; i < numModules / sizeof(HMODULE) && i < moduleList.size(); i++) {
+		std::string name(64, '\0');
+		int length = GetModuleBaseNameA(_handle, moduleList[i], &name[0], static_cast<DWORD>(name.size()));
+		name.resize(length);
+		if (moduleName == name) return reinterpret_cast<uintptr_t>(moduleList[i]);
+	}
+	return 0;
+}
+
+bool Win32MemoryBackend::read(const void* address, void* buffer, size_t size) {
+	return ReadProcessMemory(_handle, address, buffer, size, nullptr);
+}
+
+bool Win32MemoryBackend::write(void* address, const void* buffer, size_t size) {
+	return WriteProcessMemory(_handle, address, buffer, size, nullptr);
+}
+
+void* Win32MemoryBackend::alloc(size_t size, bool executable) {
+	return VirtualAllocEx(_handle, NULL, size, MEM_COMMIT | MEM_RESERVE, executable ? PAGE_EXECUTE_READWRITE : PAGE_READWRITE);
+}
+
+bool Win32MemoryBackend::execute(void* address, bool wait) {
+	HANDLE thread = CreateRemoteThread(_handle, NULL, 0, (LPTHREAD_START_ROUTINE)address, NULL, 0, 0);
+	if (!thread) return false;
+	if (wait) WaitForSingleObject(thread, INFINITE);
+	CloseHandle(thread);
+	return true;
+}
+
+#endif
+
+#ifdef __linux__
+
+LinuxMemoryBackend::~LinuxMemoryBackend() {
+	close();
+}
+
+// The executable name of a Wine process is the last part of its first argument, which is a Windows path
+static std::string wineExeName(int pid) {
+	std::ifstream file("/proc/" + std::to_string(pid) + "/cmdline");
+	std::string command;
+	std::getline(file, command, '\0');
+	size_t slash = command.find_last_of("\\/");
+	return slash == std::string::npos ? command : command.substr(slash + 1);
+}
+
+int LinuxMemoryBackend::findProcess(const std::string& processName) {
+	DIR* proc = opendir("/proc");
+	if (!proc) return 0;
+	int found = 0;
+	while (dirent* entry = readdir(proc)) {
+		int pid = atoi(entry->d_name);
+		if (pid > 0 && wineExeName(pid) == processName) {
+			found = pid;
+			break;
+		}
+	}
+	closedir(proc);
+	return found;
+}
+
+bool LinuxMemoryBackend::open(const std::string& processName) {
+	close();
+	_pid = findProcess(processName);
+	if (_pid == 0) return false;
+	_memFile = ::open(("/proc/" + std::to_string(_pid) + "/mem").c_str(), O_RDWR);
+	return true;
+}
+
+void LinuxMemoryBackend::close() {
+	if (_memFile != -1) ::close(_memFile);
+	_memFile = -1;
+	_pid = 0;
+}
+
+bool LinuxMemoryBackend::isRunning(const std::string& processName) {
+	return findProcess(processName) != 0;
+}
+
+bool LinuxMemoryBackend::isAlive() {
+	return _pid != 0 && (kill(_pid, 0) == 0 || errno == EPERM);
+}
+
+// Wine maps each PE image from its file, so the module's base is the lowest mapping of that file
+uintptr_t LinuxMemoryBackend::moduleBase(const std::string& moduleName) {
+	std::ifstream maps("/proc/" + std::to_string(_pid) + "/maps");
+	std::string line;
+	uintptr_t base = 0;
+	while (std::getline(maps, line)) {
+		size_t slash = line.find_last_of('/');
+		if (slash == std::string::npos || line.size() - slash - 1 != moduleName.size()) continue;
+		if (!std::equal(moduleName.begin(), moduleName.end(), line.begin() + slash + 1, [](char a, char b) { return tolower(a) == tolower(b); })) continue;
+		uintptr_t start = std::stoull(line.substr(0, line.find('-')), nullptr, 16);
+		if (base == 0 || start < base) base = start;
+	}
+	return base;
+}
+
+bool LinuxMemoryBackend::read(const void* address, void* buffer, size_t size) {
+	iovec local = { buffer, size };
+	iovec remote = { const_cast<void*>(address), size };
+	return process_vm_readv(_pid, &local, 1, &remote, 1, 0) == static_cast<ssize_t>(size);
+}
+
+bool LinuxMemoryBackend::write(void* address, const void* buffer, size_t size) {
+	iovec local = { const_cast<void*>(buffer), size };
+	iovec remote = { address, size };
+	if (process_vm_writev(_pid, &local, 1, &remote, 1, 0) == static_cast<ssize_t>(size)) return true;
+	// process_vm_writev respects page protections, but /proc/<pid>/mem can write to code
+	return _memFile != -1 && pwrite(_memFile, buffer, size, static_cast<off_t>(reinterpret_cast<uintptr_t>(address))) == static_cast<ssize_t>(size);
+}
+
+// process_vm_readv stops at the first range that can't be read, so the read is restarted after that range until every range was tried
+void LinuxMemoryBackend::read(std::vector<MemoryRange>& ranges) {
+	std::vector<MemoryRange*> pending;
+	for (MemoryRange& range : ranges) {
+		range.ok = false;
+		if (range.address != 0) pending.push_back(&range);
+	}
+	size_t next = 0;
+	while (next < pending.size()) {
+		std::vector<iovec> local, remote;
+		for (size_t i = next; i < pending.size() && local.size() < LINUX_MAX_IOVECS; i++) {
+			local.push_back({ pending[i]->buffer, pending[i]->size });
+			remote.push_back({ reinterpret_cast<void*>(pending[i]->address), pending[i]->size });
+		}
+		ssize_t bytes = process_vm_readv(_pid, &local[0], local.size(), &remote[0], remote.size(), 0);
+		size_t done = 0;
+		while (bytes > 0 && done < local.size() && static_cast<size_t>(bytes) >= local[done].iov_len) {
+			pending[next + done]->ok = true;
+			bytes -= local[done].iov_len;
+			done++;
+		}
+		if (done < local.size()) done++; // This range failed (or was only partly read)
+		next += done;
+	}
+}
+
+#endif
+
+void FakeMemoryBackend::addProcess(const std::string& processName, uintptr_t base) {
+	_processes.insert(processName);
+	_modules[processName] = base;
+}
+
+bool FakeMemoryBackend::open(const std::string& processName) {
+	_alive = _processes.count(processName) > 0;
+	return _alive;
+}
+
+uintptr_t FakeMemoryBackend::moduleBase(const std::string& moduleName) {
+	auto search = _modules.find(moduleName);
+	return search == _modules.end() ? 0 : search->second;
+}
+
+// Local copy of [address, address + size), or nullptr if it isn't inside a single region
+uint8_t* FakeMemoryBackend::find(uintptr_t address, size_t size) {
+	auto region = _regions.upper_bound(address);
+	if (region == _regions.begin()) return nullptr;
+	region--;
+	if (address + size > region->first + region->second.size()) return nullptr;
+	return &region->second[address - region->first];
+}
+
+void FakeMemoryBackend::map(uintptr_t address, const std::vector<uint8_t>& data) {
+	std::unique_lock<std::shared_mutex> lock(_regionsMtx);
+	_regions[address] = data;
+}
+
+bool FakeMemoryBackend::read(const void* address, void* buffer, size_t size) {
+	std::shared_lock<std::shared_mutex> lock(_regionsMtx);
+	uint8_t* data = _alive ? find(reinterpret_cast<uintptr_t>(address), size) : nullptr;
+	if (!data) return false;
+	std::memcpy(buffer, data, size);
+	return true;
+}
+
+bool FakeMemoryBackend::write(void* address, const void* buffer, size_t size) {
+	std::shared_lock<std::shared_mutex> lock(_regionsMtx);
+	uint8_t* data = _alive ? find(reinterpret_cast<uintptr_t>(address), size) : nullptr;
+	if (!data) return false;
+	std::memcpy(data, buffer, size);
+	return true;
+}
+
+void* FakeMemoryBackend::alloc(size_t size, bool /*executable*/) {
+	if (!_alive) return nullptr;
+	std::unique_lock<std::shared_mutex> lock(_regionsMtx);
+	uintptr_t address = _nextAlloc;
+	_regions[address] = std::vector<uint8_t>(size, 0);
+	_nextAlloc += (std::max<size_t>(size, 1) + 0xFFF) & ~static_cast<uintptr_t>(0xFFF); // Page aligned, like VirtualAllocEx
+	return reinterpret_cast<void*>(address);
+}
+
+bool FakeMemoryBackend::execute(void* address, bool /*wait*/) {
+	if (!_alive) return false;
+	executed.push_back(reinterpret_cast<uintptr_t>(address));
+	if (onExecute) onExecute(reinterpret_cast<uintptr_t>(address));
+	return true;
+}
@@ -0,0 +1,159 @@
+#pragma once
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <set>
+#include <shared_mutex>
+#include <string>
+#include <vector>
+
+// One entry of a batched read or write: either an absolute address, or a field of a panel. ok is set once the batch has run.
+struct MemoryRange
+{
+	MemoryRange(uintptr_t address, size_t size, void* buffer) : address(address), size(size), buffer(buffer) {}
+	MemoryRange(int panel, int offset, size_t size, void* buffer) : panel(panel), offset(offset), size(size), buffer(buffer) {}
+
+	uintptr_t address = 0;
+	int panel = -1; // -1 if address is used instead
+	int offset = 0;
+	size_t size;
+	void* buffer;
+	bool ok = false;
+};
+
+// Everything Memory needs from the operating system to work with another process. Memory only reaches the game through this,
+//   so the same code can run against the game on Windows, a Wine-hosted game from Linux, or a fake process in tests.
+// Memory calls read and write from several threads at once, and alongside alloc and execute. Only open and close are never concurrent.
+class MemoryBackend
+{
+public:
+	virtual ~MemoryBackend() = default;
+
+	// The backend for the platform this was built for.
+	static std::unique_ptr<MemoryBackend> create();
+
+	// Attach to the first process with the given executable name. Returns false if it isn't running.
+	virtual bool open(const std::string& processName) = 0;
+	virtual void close() = 0;
+	// Whether a process with the given executable name is running, without attaching to it.
+	virtual bool isRunning(const std::string& processName) = 0;
+	// Whether the attached process is still running.
+	virtual bool isAlive() = 0;
+	// Address the given module is loaded at in the attached process, or 0 if it isn't loaded.
+	virtual uintptr_t moduleBase(const std::string& moduleName) = 0;
+
+	virtual bool read(const void* address, void* buffer, size_t size) = 0;
+	virtual bool write(void* address, const void* buffer, size_t size) = 0;
+	bool read(uintptr_t address, void* buffer, size_t size) { return read(reinterpret_cast<const void*>(address), buffer, size); }
+	bool write(uintptr_t address, const void* buffer, size_t size) { return write(reinterpret_cast<void*>(address), buffer, size); }
+
+	// Read or write every range with a non-zero address, setting ok on each. Backends that can do several ranges in one call override these.
+	virtual void read(std::vector<MemoryRange>& ranges);
+	virtual void write(std::vector<MemoryRange>& ranges);
+
+	// Allocate memory in the attached process. Returns nullptr if that isn't possible.
+	virtual void* alloc(size_t size, bool executable) = 0;
+	// Run the code at address on a new thread in the attached process, and optionally wait for it to return.
+	virtual bool execute(void* address, bool wait) = 0;
+
+	// The operating system's handle for the attached process, if it has one.
+	virtual void* handle() { return nullptr; }
+};
+
+#ifdef _WIN32
+// The game running on Windows (or the randomizer running inside the same Wine prefix as the game).
+class Win32MemoryBackend : public MemoryBackend
+{
+public:
+	~Win32MemoryBackend();
+
+	bool open(const std::string& processName) override;
+	void close() override;
+	bool isRunning(const std::string& processName) override;
+	bool isAlive() override;
+	uintptr_t moduleBase(const std::string& moduleName) override;
+	bool read(const void* address, void* buffer, size_t size) override;
+	bool write(void* address, const void* buffer, size_t size) override;
+	using MemoryBackend::read;
+	using MemoryBackend::write;
+	void* alloc(size_t size, bool executable) override;
+	bool execute(void* address, bool wait) override;
+	void* handle() override { return _handle; }
+
+private:
+	void* _handle = nullptr;
+};
+#endif
+
+#ifdef __linux__
+// A Wine-hosted game, seen from a native Linux process. Modules are found through /proc/<pid>/maps, and memory is accessed with
+//   process_vm_readv/process_vm_writev. Remote allocation and calls would need code running inside the Wine process, so they aren't supported.
+// Nothing in the randomizer can use this yet: Memory and the AP client still need windows.h, so the randomizer only builds for Windows, where
+//   create() always picks Win32MemoryBackend. It only builds with this file on its own, for Linux tools that construct it directly.
+class LinuxMemoryBackend : public MemoryBackend
+{
+public:
+	~LinuxMemoryBackend();
+
+	bool open(const std::string& processName) override;
+	void close() override;
+	bool isRunning(const std::string& processName) override;
+	bool isAlive() override;
+	uintptr_t moduleBase(const std::string& moduleName) override;
+	bool read(const void* address, void* buffer, size_t size) override;
+	bool write(void* address, const void* buffer, size_t size) override;
+	using MemoryBackend::read;
+	using MemoryBackend::write;
+	void read(std::vector<MemoryRange>& ranges) override;
+	void* alloc(size_t /*size*/, bool /*executable*/) override { return nullptr; }
+	bool execute(void* /*address*/, bool /*wait*/) override { return false; }
+
+private:
+	int findProcess(const std::string& processName);
+
+	int _pid = 0;
+	int _memFile = -1; // /proc/<pid>/mem, for writes to pages that process_vm_writev can't write (code patches)
+};
+#endif
+
+// A process that only exists in memory, for running the randomizer, watchdogs and AP logic without the game. Everything is deterministic:
+//   regions are mapped explicitly, allocations come from a fixed address range, and remote calls are recorded instead of run.
+class FakeMemoryBackend : public MemoryBackend
+{
+public:
+	// Make the fake process exist, with its main module loaded at base.
+	void addProcess(const std::string& processName, uintptr_t base);
+	void addModule(const std::string& moduleName, uintptr_t base) { _modules[moduleName] = base; }
+	// Add a readable and writable region. Regions must not overlap.
+	void map(uintptr_t address, size_t size) { map(address, std::vector<uint8_t>(size, 0)); }
+	void map(uintptr_t address, const std::vector<uint8_t>& data);
+	// Simulate the game closing.
+	void kill() { _processes.clear(); _alive = false; }
+
+	bool open(const std::string& processName) override;
+	void close() override { _alive = false; }
+	bool isRunning(const std::string& processName) override { return _processes.count(processName) > 0; }
+	bool isAlive() override { return _alive; }
+	uintptr_t moduleBase(const std::string& moduleName) override;
+	bool read(const void* address, void* buffer, size_t size) override;
+	bool write(void* address, const void* buffer, size_t size) override;
+	using MemoryBackend::read;
+	using MemoryBackend::write;
+	void* alloc(size_t size, bool executable) override;
+	bool execute(void* address, bool wait) override;
+
+	std::vector<uintptr_t> executed; // Start address of every remote call, in order
+	std::function<void(uintptr_t address)> onExecute; // Called for each remote call, to simulate what the code would have done
+
+private:
+	uint8_t* find(uintptr_t address, size_t size);
+
+	std::shared_mutex _regionsMtx; // Reads and writes share it, mapping new regions takes it exclusively
+	std::map<uintptr_t, std::vector<uint8_t>> _regions; // By start address
+	std::map<std::string, uintptr_t> _modules;
+	std::set<std::string> _processes;
+	uintptr_t _nextAlloc = 0x7F0000000000;
+	bool _alive = false;
+};
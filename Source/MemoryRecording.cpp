@@ -0,0 +1,448 @@
+// This is an open source non-commercial project. Dear PVS-Studio, please check it.
+
+// PVS-Studio Static Code Analyzer for C, C++, C#, and Java: http://www.viva64.com
+
+#include "MemoryRecording.h"
+#include <cstring>
+#include <iterator>
+#include <sstream>
+
+static const char recordingMagic[] = "WRPGREC"; // Followed by RECORDING_VERSION, which fills out the first 8 bytes
+
+static void putVarint(std::vector<uint8_t>& buffer, uint64_t value) {
+	while (value >= 0x80) {
+		buffer.push_back(static_cast<uint8_t>(value) | 0x80);
+		value >>= 7;
+	}
+	buffer.push_back(static_cast<uint8_t>(value));
+}
+
+// Reads the log back, keeping track of the previous address as the recorder did.
+class RecordingReader
+{
+public:
+	RecordingReader(const std::vector<uint8_t>& data) : _data(data) {}
+
+	bool done() const { return _pos >= _data.size(); }
+	bool failed() const { return _failed; }
+
+	uint8_t byte() {
+		if (_pos >= _data.size()) {
+			_failed = true;
+			return 0;
+		}
+		return _data[_pos++];
+	}
+
+	uint64_t varint() {
+		uint64_t value = 0;
+		for (int shift = 0; shift < 64; shift += 7) {
+			uint8_t b = byte();
+			value |= static_cast<uint64_t>(b & 0x7F) << shift;
+			if (!(b & 0x80)) return value;
+		}
+		_failed = true;
+		return 0;
+	}
+
+	uintptr_t address() {
+		uint64_t zigzag = varint();
+		int64_t delta = static_cast<int64_t>(zigzag >> 1) ^ -static_cast<int64_t>(zigzag & 1);
+		_lastAddress += static_cast<uintptr_t>(delta);
+		return _lastAddress;
+	}
+
+	std::string string() {
+		size_t size = static_cast<size_t>(varint());
+		if (size > _data.size() - _pos) {
+			_failed = true;
+			return "";
+		}
+		_pos += size;
+		return std::string(_data.begin() + (_pos - size), _data.begin() + _pos);
+	}
+
+	std::vector<uint8_t> bytes(size_t size) {
+		if (size > _data.size() - _pos) {
+			_failed = true;
+			return {};
+		}
+		_pos += size;
+		return std::vector<uint8_t>(_data.begin() + (_pos - size), _data.begin() + _pos);
+	}
+
+private:
+	const std::vector<uint8_t>& _data;
+	size_t _pos = 0;
+	uintptr_t _lastAddress = 0;
+	bool _failed = false;
+};
+
+static std::string hexAddress(uintptr_t address) {
+	std::stringstream ss;
+	ss << "0x" << std::hex << address;
+	return ss.str();
+}
+
+RecordingMemoryBackend::RecordingMemoryBackend(std::unique_ptr<MemoryBackend> backend, const std::string& path) : _backend(std::move(backend)) {
+	_file.open(path, std::ios::binary | std::ios::trunc);
+	if (!_file.is_open()) return;
+	_file.write(recordingMagic, sizeof(recordingMagic) - 1);
+	_file.put(static_cast<char>(RECORDING_VERSION));
+}
+
+RecordingMemoryBackend::~RecordingMemoryBackend() {
+	flush();
+}
+
+void RecordingMemoryBackend::flush() {
+	std::lock_guard<std::mutex> lock(_logMtx);
+	if (!_file.is_open() || _buffer.empty()) return;
+	_file.write(reinterpret_cast<const char*>(&_buffer[0]), _buffer.size());
+	_file.flush();
+	_buffer.clear();
+}
+
+void RecordingMemoryBackend::putAddress(uintptr_t address) {
+	int64_t delta = static_cast<int64_t>(address - _lastAddress);
+	putVarint(_buffer, (static_cast<uint64_t>(delta) << 1) ^ static_cast<uint64_t>(delta >> 63));
+	_lastAddress = address;
+}
+
+void RecordingMemoryBackend::log(const RecordedAccess& access) {
+	std::lock_guard<std::mutex> lock(_logMtx);
+	if (!_file.is_open()) return;
+
+	RecordedOp op = access.op;
+	if (op == RecordedOp::Read && access.ok) {
+		std::vector<uint8_t>& last = _lastReads[{ access.address, access.size }];
+		if (last == access.data) op = RecordedOp::ReadRepeat;
+		else last = access.data;
+	}
+
+	_buffer.push_back(static_cast<uint8_t>(op));
+	switch (op) {
+	case RecordedOp::Open:
+	case RecordedOp::IsRunning:
+		putVarint(_buffer, access.name.size());
+		_buffer.insert(_buffer.end(), access.name.begin(), access.name.end());
+		_buffer.push_back(access.ok);
+		break;
+	case RecordedOp::Close:
+		break;
+	case RecordedOp::IsAlive:
+		_buffer.push_back(access.ok);
+		break;
+	case RecordedOp::ModuleBase:
+		putVarint(_buffer, access.name.size());
+		_buffer.insert(_buffer.end(), access.name.begin(), access.name.end());
+		putVarint(_buffer, access.address);
+		break;
+	case RecordedOp::Read:
+	case RecordedOp::Write:
+		putAddress(access.address);
+		putVarint(_buffer, access.size);
+		_buffer.push_back(access.ok);
+		if (op == RecordedOp::Write || access.ok) _buffer.insert(_buffer.end(), access.data.begin(), access.data.end());
+		break;
+	case RecordedOp::ReadRepeat:
+		putAddress(access.address);
+		putVarint(_buffer, access.size);
+		break;
+	case RecordedOp::Alloc:
+		putVarint(_buffer, access.size);
+		_buffer.push_back(access.flag);
+		putVarint(_buffer, access.address);
+		break;
+	case RecordedOp::Execute:
+		putAddress(access.address);
+		_buffer.push_back(access.flag);
+		_buffer.push_back(access.ok);
+		break;
+	}
+
+	if (_buffer.size() < RECORDING_FLUSH_SIZE) return;
+	_file.write(reinterpret_cast<const char*>(&_buffer[0]), _buffer.size());
+	_buffer.clear();
+}
+
+bool RecordingMemoryBackend::open(const std::string& processName) {
+	RecordedAccess access = { RecordedOp::Open, processName };
+	access.ok = _backend->open(processName);
+	log(access);
+	return access.ok;
+}
+
+void RecordingMemoryBackend::close() {
+	_backend->close();
+	log({ RecordedOp::Close });
+	flush();
+}
+
+bool RecordingMemoryBackend::isRunning(const std::string& processName) {
+	RecordedAccess access = { RecordedOp::IsRunning, processName };
+	access.ok = _backend->isRunning(processName);
+	log(access);
+	return access.ok;
+}
+
+bool RecordingMemoryBackend::isAlive() {
+	RecordedAccess access = { RecordedOp::IsAlive };
+	access.ok = _backend->isAlive();
+	log(access);
+	return access.ok;
+}
+
+uintptr_t RecordingMemoryBackend::moduleBase(const std::string& moduleName) {
+	RecordedAccess access = { RecordedOp::ModuleBase, moduleName };
+	access.address = _backend->moduleBase(moduleName);
+	log(access);
+	return access.address;
+}
+
+bool RecordingMemoryBackend::read(const void* address, void* buffer, size_t size) {
+	RecordedAccess access = { RecordedOp::Read, "", reinterpret_cast<uintptr_t>(address), size };
+	access.ok = _backend->read(address, buffer, size);
+	if (access.ok) access.data.assign(static_cast<uint8_t*>(buffer), static_cast<uint8_t*>(buffer) + size);
+	log(access);
+	return access.ok;
+}
+
+bool RecordingMemoryBackend::write(void* address, const void* buffer, size_t size) {
+	RecordedAccess access = { RecordedOp::Write, "", reinterpret_cast<uintptr_t>(address), size };
+	access.data.assign(static_cast<const uint8_t*>(buffer), static_cast<const uint8_t*>(buffer) + size);
+	access.ok = _backend->write(address, buffer, size);
+	log(access);
+	return access.ok;
+}
+
+void RecordingMemoryBackend::read(std::vector<MemoryRange>& ranges) {
+	_backend->read(ranges);
+	for (const MemoryRange& range : ranges) {
+		if (range.address == 0) continue;
+		RecordedAccess access = { RecordedOp::Read, "", range.address, range.size };
+		access.ok = range.ok;
+		if (range.ok) access.data.assign(static_cast<uint8_t*>(range.buffer), static_cast<uint8_t*>(range.buffer) + range.size);
+		log(access);
+	}
+}
+
+void RecordingMemoryBackend::write(std::vector<MemoryRange>& ranges) {
+	_backend->write(ranges);
+	for (const MemoryRange& range : ranges) {
+		if (range.address == 0) continue;
+		RecordedAccess access = { RecordedOp::Write, "", range.address, range.size };
+		access.data.assign(static_cast<uint8_t*>(range.buffer), static_cast<uint8_t*>(range.buffer) + range.size);
+		access.ok = range.ok;
+		log(access);
+	}
+}
+
+void* RecordingMemoryBackend::alloc(size_t size, bool executable) {
+	RecordedAccess access = { RecordedOp::Alloc, "", 0, size };
+	access.flag = executable;
+	void* address = _backend->alloc(size, executable);
+	access.address = reinterpret_cast<uintptr_t>(address);
+	access.ok = address != nullptr;
+	log(access);
+	return address;
+}
+
+bool RecordingMemoryBackend::execute(void* address, bool wait) {
+	RecordedAccess access = { RecordedOp::Execute, "", reinterpret_cast<uintptr_t>(address) };
+	access.flag = wait;
+	access.ok = _backend->execute(address, wait);
+	log(access);
+	return access.ok;
+}
+
+bool RecordingMemoryBackend::load(const std::string& path, std::vector<RecordedAccess>& accesses) {
+	std::ifstream file(path, std::ios::binary);
+	if (!file.is_open()) return false;
+	std::vector<uint8_t> data((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+	size_t headerSize = sizeof(recordingMagic) - 1;
+	if (data.size() <= headerSize || std::memcmp(&data[0], recordingMagic, headerSize) != 0 || data[headerSize] != RECORDING_VERSION) return false;
+	data.erase(data.begin(), data.begin() + headerSize + 1);
+
+	RecordingReader reader(data);
+	std::map<std::pair<uintptr_t, size_t>, std::vector<uint8_t>> lastReads;
+	while (!reader.done()) {
+		RecordedAccess access = { static_cast<RecordedOp>(reader.byte()) };
+		switch (access.op) {
+		case RecordedOp::Open:
+		case RecordedOp::IsRunning:
+			access.name = reader.string();
+			access.ok = reader.byte();
+			break;
+		case RecordedOp::Close:
+			break;
+		case RecordedOp::IsAlive:
+			access.ok = reader.byte();
+			break;
+		case RecordedOp::ModuleBase:
+			access.name = reader.string();
+			access.address = static_cast<uintptr_t>(reader.varint());
+			access.ok = access.address != 0;
+			break;
+		case RecordedOp::Read:
+		case RecordedOp::Write:
+			access.address = reader.address();
+			access.size = static_cast<size_t>(reader.varint());
+			access.ok = reader.byte();
+			if (access.op == RecordedOp::Write || access.ok) access.data = reader.bytes(access.size);
+			if (access.op == RecordedOp::Read && access.ok) lastReads[{ access.address, access.size }] = access.data;
+			break;
+		case RecordedOp::ReadRepeat:
+			access.op = RecordedOp::Read;
+			access.address = reader.address();
+			access.size = static_cast<size_t>(reader.varint());
+			access.data = lastReads[{ access.address, access.size }];
+			access.ok = access.data.size() == access.size;
+			break;
+		case RecordedOp::Alloc:
+			access.size = static_cast<size_t>(reader.varint());
+			access.flag = reader.byte();
+			access.address = static_cast<uintptr_t>(reader.varint());
+			access.ok = access.address != 0;
+			break;
+		case RecordedOp::Execute:
+			access.address = reader.address();
+			access.flag = reader.byte();
+			access.ok = reader.byte();
+			break;
+		default:
+			return false;
+		}
+		if (reader.failed()) return false;
+		accesses.push_back(access);
+	}
+	return true;
+}
+
+ReplayMemoryBackend::ReplayMemoryBackend(const std::string& path) {
+	std::vector<RecordedAccess> accesses;
+	if (!RecordingMemoryBackend::load(path, accesses)) diverge("Couldn't load all of the recording " + path);
+	for (const RecordedAccess& access : accesses) add(access);
+}
+
+ReplayMemoryBackend::ReplayMemoryBackend(const std::vector<RecordedAccess>& accesses) {
+	for (const RecordedAccess& access : accesses) add(access);
+}
+
+void ReplayMemoryBackend::add(const RecordedAccess& access) {
+	switch (access.op) {
+	case RecordedOp::Open: _opens[access.name].pending.push_back(access.ok); break;
+	case RecordedOp::IsRunning: _running[access.name].pending.push_back(access.ok); break;
+	case RecordedOp::IsAlive: _alive.pending.push_back(access.ok); break;
+	case RecordedOp::ModuleBase: _modules[access.name].pending.push_back(access.address); break;
+	case RecordedOp::Read: _reads[{ access.address, access.size }].pending.push_back(access); break;
+	case RecordedOp::Write: _writes[{ access.address, access.size }].push_back(access); break;
+	case RecordedOp::Alloc: _allocs.push_back(access); break;
+	case RecordedOp::Execute: _executes.push_back(access); break;
+	default: break;
+	}
+}
+
+void ReplayMemoryBackend::diverge(const std::string& what) {
+	_divergences.push_back(what);
+}
+
+std::vector<std::string> ReplayMemoryBackend::divergences() {
+	std::lock_guard<std::mutex> lock(_mtx);
+	return _divergences;
+}
+
+size_t ReplayMemoryBackend::pendingWrites() {
+	std::lock_guard<std::mutex> lock(_mtx);
+	size_t pending = 0;
+	for (const auto& writes : _writes) pending += writes.second.size();
+	return pending;
+}
+
+bool ReplayMemoryBackend::open(const std::string& processName) {
+	std::lock_guard<std::mutex> lock(_mtx);
+	bool ok = false;
+	if (!_opens[processName].next(ok)) diverge("Opened " + processName + ", which wasn't recorded");
+	_attached = ok;
+	return ok;
+}
+
+void ReplayMemoryBackend::close() {
+	std::lock_guard<std::mutex> lock(_mtx);
+	_attached = false;
+}
+
+bool ReplayMemoryBackend::isRunning(const std::string& processName) {
+	std::lock_guard<std::mutex> lock(_mtx);
+	bool running = false;
+	if (!_running[processName].next(running)) diverge("Checked whether " + processName + " was running, which wasn't recorded");
+	return running;
+}
+
+// A recording that never checked simply had the game running throughout
+bool ReplayMemoryBackend::isAlive() {
+	std::lock_guard<std::mutex> lock(_mtx);
+	bool alive = false;
+	if (!_alive.next(alive)) return _attached;
+	return _attached && alive;
+}
+
+uintptr_t ReplayMemoryBackend::moduleBase(const std::string& moduleName) {
+	std::lock_guard<std::mutex> lock(_mtx);
+	uintptr_t base = 0;
+	if (!_modules[moduleName].next(base)) diverge("Looked up module " + moduleName + ", which wasn't recorded");
+	return base;
+}
+
+bool ReplayMemoryBackend::read(const void* address, void* buffer, size_t size) {
+	std::lock_guard<std::mutex> lock(_mtx);
+	RecordedAccess access;
+	if (!_reads[{ reinterpret_cast<uintptr_t>(address), size }].next(access)) {
+		diverge("Read " + std::to_string(size) + " bytes at " + hexAddress(reinterpret_cast<uintptr_t>(address)) + ", which wasn't recorded");
+		return false;
+	}
+	if (access.ok && size > 0) std::memcpy(buffer, &access.data[0], size);
+	return access.ok;
+}
+
+bool ReplayMemoryBackend::write(void* address, const void* buffer, size_t size) {
+	std::lock_guard<std::mutex> lock(_mtx);
+	std::string where = std::to_string(size) + " bytes at " + hexAddress(reinterpret_cast<uintptr_t>(address));
+	std::deque<RecordedAccess>& writes = _writes[{ reinterpret_cast<uintptr_t>(address), size }];
+	if (writes.empty()) {
+		diverge("Wrote " + where + ", which wasn't recorded");
+		return false;
+	}
+	RecordedAccess access = writes.front();
+	writes.pop_front();
+	if (size > 0 && std::memcmp(&access.data[0], buffer, size) != 0) diverge("Wrote " + where + " with different bytes than recorded");
+	return access.ok;
+}
+
+void* ReplayMemoryBackend::alloc(size_t size, bool executable) {
+	std::lock_guard<std::mutex> lock(_mtx);
+	if (_allocs.empty()) {
+		diverge("Allocated " + std::to_string(size) + " bytes, which wasn't recorded");
+		return nullptr;
+	}
+	RecordedAccess access = _allocs.front();
+	_allocs.pop_front();
+	if (access.size != size || access.flag != executable) {
+		diverge("Allocated " + std::to_string(size) + " bytes where " + std::to_string(access.size) + " were recorded");
+	}
+	return reinterpret_cast<void*>(access.address);
+}
+
+bool ReplayMemoryBackend::execute(void* address, bool wait) {
+	std::lock_guard<std::mutex> lock(_mtx);
+	if (_executes.empty()) {
+		diverge("Called " + hexAddress(reinterpret_cast<uintptr_t>(address)) + ", which wasn't recorded");
+		return false;
+	}
+	RecordedAccess access = _executes.front();
+	_executes.pop_front();
+	if (access.address != reinterpret_cast<uintptr_t>(address)) {
+		diverge("Called " + hexAddress(reinterpret_cast<uintptr_t>(address)) + " where " + hexAddress(access.address) + " was recorded");
+	}
+	return access.ok;
+}
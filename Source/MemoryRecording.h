@@ -0,0 +1,135 @@
+#pragma once
+#include "MemoryBackend.h"
+#include <deque>
+#include <fstream>
+
+#define RECORDING_VERSION           1 // Bumped whenever the log format changes. Logs of other versions are refused.
+#define RECORDING_FLUSH_SIZE  0x10000 // Bytes buffered before they are written to the log (64 KiB).
+
+enum class RecordedOp : uint8_t {
+	Open = 1,
+	Close,
+	IsRunning,
+	IsAlive,
+	ModuleBase,
+	Read,
+	ReadRepeat, // A read that returned the same bytes as the last read of that range. Only in the log; loading turns it back into a Read.
+	Write,
+	Alloc,
+	Execute,
+};
+
+// One call made into a backend, and what it returned.
+struct RecordedAccess {
+	RecordedOp op;
+	std::string name; // Process or module name, for Open, IsRunning and ModuleBase
+	uintptr_t address = 0; // Read, Write and Execute. For Alloc and ModuleBase, the address returned.
+	size_t size = 0; // Read, Write and Alloc
+	std::vector<uint8_t> data; // Bytes read (if ok) or written
+	bool flag = false; // Executable for Alloc, wait for Execute
+	bool ok = false;
+};
+
+// Passes everything through to another backend, logging every call and its result. The log is compact: addresses are stored as the
+//   difference to the previous one, numbers as varints, and a read that returns the same bytes as last time isn't stored again.
+// Calls are logged in the order they returned, from whichever thread made them.
+class RecordingMemoryBackend : public MemoryBackend
+{
+public:
+	// Logs to the file at path, replacing it. If it can't be created, nothing is logged.
+	RecordingMemoryBackend(std::unique_ptr<MemoryBackend> backend, const std::string& path);
+	~RecordingMemoryBackend();
+
+	bool open(const std::string& processName) override;
+	void close() override;
+	bool isRunning(const std::string& processName) override;
+	bool isAlive() override;
+	uintptr_t moduleBase(const std::string& moduleName) override;
+	bool read(const void* address, void* buffer, size_t size) override;
+	bool write(void* address, const void* buffer, size_t size) override;
+	using MemoryBackend::read;
+	using MemoryBackend::write;
+	// Each range with an address is logged as a read or write of its own, as if the base class had made it.
+	void read(std::vector<MemoryRange>& ranges) override;
+	void write(std::vector<MemoryRange>& ranges) override;
+	void* alloc(size_t size, bool executable) override;
+	bool execute(void* address, bool wait) override;
+	void* handle() override { return _backend->handle(); }
+
+	// Write out everything logged so far.
+	void flush();
+
+	// Read a whole log back. Returns false if the file is missing, isn't a log of this version, or is cut short (what came before is kept).
+	static bool load(const std::string& path, std::vector<RecordedAccess>& accesses);
+
+private:
+	void log(const RecordedAccess& access);
+	void putAddress(uintptr_t address);
+
+	std::unique_ptr<MemoryBackend> _backend;
+	std::mutex _logMtx; // Everything below
+	std::ofstream _file;
+	std::vector<uint8_t> _buffer;
+	uintptr_t _lastAddress = 0;
+	std::map<std::pair<uintptr_t, size_t>, std::vector<uint8_t>> _lastReads; // By address and size
+};
+
+// Plays a log back in place of the game. Reads return what the game returned, and writes are checked against what was written. The
+//   threads of a replay won't interleave as they did when recording, so the order is only kept per range: the nth read of a range returns
+//   the nth recorded result for it, and once those run out, the last one again. Anything that doesn't match the log is noted in divergences().
+class ReplayMemoryBackend : public MemoryBackend
+{
+public:
+	ReplayMemoryBackend(const std::string& path);
+	ReplayMemoryBackend(const std::vector<RecordedAccess>& accesses);
+
+	bool open(const std::string& processName) override;
+	void close() override;
+	bool isRunning(const std::string& processName) override;
+	bool isAlive() override;
+	uintptr_t moduleBase(const std::string& moduleName) override;
+	bool read(const void* address, void* buffer, size_t size) override;
+	bool write(void* address, const void* buffer, size_t size) override;
+	using MemoryBackend::read;
+	using MemoryBackend::write;
+	void* alloc(size_t size, bool executable) override;
+	bool execute(void* address, bool wait) override;
+
+	// Every way the replay has differed from the log so far, in order.
+	std::vector<std::string> divergences();
+	// Recorded writes that weren't made (yet).
+	size_t pendingWrites();
+
+private:
+	// The recorded results of one kind of call with the same arguments, in order.
+	template <class T> struct Results {
+		std::deque<T> pending;
+		T last = T();
+		bool seen = false;
+
+		bool next(T& result) {
+			if (!pending.empty()) {
+				last = pending.front();
+				pending.pop_front();
+				seen = true;
+			}
+			result = last;
+			return seen;
+		}
+	};
+
+	void add(const RecordedAccess& access);
+	void diverge(const std::string& what);
+
+	std::mutex _mtx; // Everything below
+	std::map<std::string, Results<bool>> _opens;
+	std::map<std::string, Results<bool>> _running;
+	Results<bool> _alive;
+	std::map<std::string, Results<uintptr_t>> _modules;
+	std::map<std::pair<uintptr_t, size_t>, Results<RecordedAccess>> _reads;
+	std::map<std::pair<uintptr_t, size_t>, std::deque<RecordedAccess>> _writes;
+	std::deque<RecordedAccess> _allocs;
+	std::deque<RecordedAccess> _executes;
+	std::vector<std::string> _divergences;
+	bool _attached = false;
+};
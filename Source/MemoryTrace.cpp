@@ -0,0 +1,254 @@
+// This is an open source non-commercial project. Dear PVS-Studio, please check it.
+
+// PVS-Studio Static Code Analyzer for C, C++, C#, and Java: http://www.viva64.com
+
+#include "MemoryTrace.h"
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <iomanip>
+#include <map>
+#include <mutex>
+#include <sstream>
+
+#define TRACE_EVENT_WORDS ((sizeof(TraceEvent) + 7) / 8)
+
+// One event, stored as relaxed atomics so that events() can read a slot while its thread overwrites it. Torn copies are thrown away.
+struct TraceSlot {
+	std::atomic<uint64_t> words[TRACE_EVENT_WORDS];
+
+	void store(const TraceEvent& event) {
+		uint64_t data[TRACE_EVENT_WORDS] = {};
+		std::memcpy(data, &event, sizeof(event));
+		for (size_t i = 0; i < TRACE_EVENT_WORDS; i++) words[i].store(data[i], std::memory_order_relaxed);
+	}
+
+	TraceEvent load() const {
+		uint64_t data[TRACE_EVENT_WORDS];
+		for (size_t i = 0; i < TRACE_EVENT_WORDS; i++) data[i] = words[i].load(std::memory_order_relaxed);
+		TraceEvent event;
+		std::memcpy(&event, data, sizeof(event));
+		return event;
+	}
+};
+
+// The events of one thread. Only that thread writes to it; events() reads it from wherever.
+struct TraceRing {
+	std::array<TraceSlot, TRACE_RING_SIZE> slots;
+	std::atomic<uint64_t> head = 0; // Number of events ever recorded
+	std::atomic<uint64_t> floor = 0; // Events before this were cleared
+	uint16_t thread = 0;
+};
+
+static std::mutex ringsMtx; // Only taken when a thread records its first event, and by events()
+static std::vector<std::shared_ptr<TraceRing>> rings; // Kept after their thread exits, so its events can still be read
+
+static thread_local std::shared_ptr<TraceRing> localRing;
+static thread_local const char* localTag = nullptr;
+static thread_local int localPanel = -1;
+static thread_local int localOffset = 0;
+
+std::atomic<bool> MemoryTrace::_enabled = false;
+std::atomic<int64_t> MemoryTrace::_start = 0;
+
+static int64_t steadyNanoseconds() {
+	return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+static int latencyBucket(uint64_t latency) {
+	uint64_t microseconds = latency / 1000;
+	int bucket = 0;
+	while (microseconds > 0 && bucket < TRACE_LATENCY_BUCKETS - 1) {
+		microseconds >>= 1;
+		bucket++;
+	}
+	return bucket;
+}
+
+void MemoryTrace::enable(bool on) {
+	if (on && !enabled()) _start = steadyNanoseconds();
+	_enabled = on;
+}
+
+void MemoryTrace::clear() {
+	std::lock_guard<std::mutex> lock(ringsMtx);
+	for (const std::shared_ptr<TraceRing>& ring : rings) ring->floor = ring->head.load();
+}
+
+uint64_t MemoryTrace::now() {
+	return steadyNanoseconds() - _start.load(std::memory_order_relaxed);
+}
+
+void MemoryTrace::record(TraceKind kind, size_t size, uint64_t start, bool ok) {
+	record(kind, localPanel, localOffset, size, start, now() - start, ok);
+}
+
+void MemoryTrace::record(TraceKind kind, int panel, int offset, size_t size, uint64_t start, uint64_t latency, bool ok) {
+	if (!localRing) {
+		localRing = std::make_shared<TraceRing>();
+		std::lock_guard<std::mutex> lock(ringsMtx);
+		localRing->thread = static_cast<uint16_t>(rings.size());
+		rings.push_back(localRing);
+	}
+	TraceRing& ring = *localRing;
+	uint64_t head = ring.head.load(std::memory_order_relaxed);
+	TraceEvent event;
+	event.timestamp = start;
+	event.tag = localTag;
+	event.panel = panel;
+	event.offset = offset;
+	event.size = static_cast<uint32_t>(size);
+	event.latency = static_cast<uint32_t>(std::min<uint64_t>(latency, UINT32_MAX));
+	event.thread = ring.thread;
+	event.kind = kind;
+	event.ok = ok;
+	ring.slots[head % TRACE_RING_SIZE].store(event);
+	ring.head.store(head + 1, std::memory_order_release);
+}
+
+std::vector<TraceEvent> MemoryTrace::events() {
+	std::vector<TraceEvent> events;
+	std::lock_guard<std::mutex> lock(ringsMtx);
+	for (const std::shared_ptr<TraceRing>& ring : rings) {
+		uint64_t head = ring->head.load(std::memory_order_acquire);
+		uint64_t first = std::max(ring->floor.load(), head > TRACE_RING_SIZE ? head - TRACE_RING_SIZE : 0);
+		size_t size = events.size();
+		for (uint64_t i = first; i < head; i++) events.push_back(ring->slots[i % TRACE_RING_SIZE].load());
+
+		// The thread may have lapped us while we were copying. Whatever it could have overwritten is dropped.
+		std::atomic_thread_fence(std::memory_order_acquire);
+		uint64_t end = ring->head.load(std::memory_order_relaxed);
+		// The event being written when we looked (number end) replaces number end - TRACE_RING_SIZE, so that one is dropped too.
+		if (end + 1 > first + TRACE_RING_SIZE) {
+			size_t overwritten = static_cast<size_t>(std::min(end + 1 - TRACE_RING_SIZE - first, head - first));
+			events.erase(events.begin() + size, events.begin() + size + overwritten);
+		}
+	}
+	std::sort(events.begin(), events.end(), [](const TraceEvent& a, const TraceEvent& b) { return a.timestamp < b.timestamp; });
+	return events;
+}
+
+std::vector<TraceSummary> MemoryTrace::summarize() {
+	std::map<std::string, TraceSummary> byTag;
+	for (const TraceEvent& event : events()) {
+		std::string tag = event.tag ? event.tag : "";
+		TraceSummary& summary = byTag[tag];
+		summary.tag = tag;
+		summary.count[static_cast<int>(event.kind)]++;
+		summary.bytes[static_cast<int>(event.kind)] += event.size;
+		if (!event.ok) summary.failed++;
+		summary.latency += event.latency;
+		summary.histogram[latencyBucket(event.latency)]++;
+	}
+
+	std::vector<TraceSummary> summaries;
+	for (const auto& entry : byTag) summaries.push_back(entry.second);
+	std::sort(summaries.begin(), summaries.end(), [](const TraceSummary& a, const TraceSummary& b) { return a.latency > b.latency; });
+	return summaries;
+}
+
+// Upper bound, in microseconds, of the bucket that the given fraction of events falls in.
+static uint64_t percentile(const TraceSummary& summary, double fraction) {
+	uint64_t total = 0;
+	for (uint64_t count : summary.histogram) total += count;
+	uint64_t seen = 0;
+	for (int i = 0; i < TRACE_LATENCY_BUCKETS; i++) {
+		seen += summary.histogram[i];
+		if (seen >= total * fraction) return 1ull << i;
+	}
+	return 1ull << (TRACE_LATENCY_BUCKETS - 1);
+}
+
+std::string MemoryTrace::report() {
+	std::ostringstream ss;
+	ss << std::left << std::setw(40) << "caller" << std::right << std::setw(9) << "reads" << std::setw(9) << "writes" << std::setw(8) << "allocs"
+		<< std::setw(8) << "calls" << std::setw(10) << "KiB" << std::setw(8) << "failed" << std::setw(10) << "total ms" << std::setw(10) << "p50 us"
+		<< std::setw(10) << "p99 us" << "\n";
+	for (const TraceSummary& summary : summarize()) {
+		uint64_t bytes = 0;
+		for (uint64_t b : summary.bytes) bytes += b;
+		ss << std::left << std::setw(40) << (summary.tag.empty() ? "(untagged)" : summary.tag) << std::right
+			<< std::setw(9) << summary.count[static_cast<int>(TraceKind::Read)]
+			<< std::setw(9) << summary.count[static_cast<int>(TraceKind::Write)]
+			<< std::setw(8) << summary.count[static_cast<int>(TraceKind::Alloc)]
+			<< std::setw(8) << summary.count[static_cast<int>(TraceKind::Call)]
+			<< std::setw(10) << bytes / 1024
+			<< std::setw(8) << summary.failed
+			<< std::setw(10) << summary.latency / 1000000
+			<< std::setw(10) << percentile(summary, 0.5)
+			<< std::setw(10) << percentile(summary, 0.99) << "\n";
+	}
+	return ss.str();
+}
+
+TraceScope::TraceScope(const char* tag) : _previous(localTag) {
+	localTag = tag;
+}
+
+TraceScope::~TraceScope() {
+	localTag = _previous;
+}
+
+TracePanel::TracePanel(int panel, int offset) : _previousPanel(localPanel), _previousOffset(localOffset) {
+	localPanel = panel;
+	localOffset = offset;
+}
+
+TracePanel::~TracePanel() {
+	localPanel = _previousPanel;
+	localOffset = _previousOffset;
+}
+
+bool TracingMemoryBackend::read(const void* address, void* buffer, size_t size) {
+	if (!MemoryTrace::enabled()) return _backend->read(address, buffer, size);
+	uint64_t start = MemoryTrace::now();
+	bool ok = _backend->read(address, buffer, size);
+	MemoryTrace::record(TraceKind::Read, size, start, ok);
+	return ok;
+}
+
+bool TracingMemoryBackend::write(void* address, const void* buffer, size_t size) {
+	if (!MemoryTrace::enabled()) return _backend->write(address, buffer, size);
+	uint64_t start = MemoryTrace::now();
+	bool ok = _backend->write(address, buffer, size);
+	MemoryTrace::record(TraceKind::Write, size, start, ok);
+	return ok;
+}
+
+void TracingMemoryBackend::read(std::vector<MemoryRange>& ranges) {
+	if (!MemoryTrace::enabled()) return _backend->read(ranges);
+	uint64_t start = MemoryTrace::now();
+	_backend->read(ranges);
+	recordBatch(TraceKind::Read, ranges, start);
+}
+
+void TracingMemoryBackend::write(std::vector<MemoryRange>& ranges) {
+	if (!MemoryTrace::enabled()) return _backend->write(ranges);
+	uint64_t start = MemoryTrace::now();
+	_backend->write(ranges);
+	recordBatch(TraceKind::Write, ranges, start);
+}
+
+void TracingMemoryBackend::recordBatch(TraceKind kind, const std::vector<MemoryRange>& ranges, uint64_t start) {
+	if (ranges.empty()) return;
+	uint64_t latency = (MemoryTrace::now() - start) / ranges.size();
+	for (const MemoryRange& range : ranges) {
+		MemoryTrace::record(kind, range.panel, range.offset, range.size, start, latency, range.ok);
+	}
+}
+
+void* TracingMemoryBackend::alloc(size_t size, bool executable) {
+	if (!MemoryTrace::enabled()) return _backend->alloc(size, executable);
+	uint64_t start = MemoryTrace::now();
+	void* address = _backend->alloc(size, executable);
+	MemoryTrace::record(TraceKind::Alloc, size, start, address != nullptr);
+	return address;
+}
+
+bool TracingMemoryBackend::execute(void* address, bool wait) {
+	if (!MemoryTrace::enabled()) return _backend->execute(address, wait);
+	uint64_t start = MemoryTrace::now();
+	bool ok = _backend->execute(address, wait);
+	MemoryTrace::record(TraceKind::Call, 0, start, ok);
+	return ok;
+}
@@ -0,0 +1,126 @@
+#pragma once
+#include "MemoryBackend.h"
+#include <array>
+#include <atomic>
+
+#define TRACE_RING_SIZE       0x2000 // Events kept per thread. Once a thread's ring is full, its oldest events are overwritten.
+#define TRACE_LATENCY_BUCKETS     20 // Histogram buckets. Bucket 0 is under 1 us, bucket i is [2^(i-1), 2^i) us, and the last takes the rest.
+
+enum class TraceKind : uint8_t {
+	Read,
+	Write,
+	Alloc,
+	Call,
+};
+#define TRACE_KINDS 4
+
+// One access to the game's memory.
+struct TraceEvent {
+	uint64_t timestamp; // Nanoseconds since the trace was enabled
+	const char* tag; // Innermost TraceScope of the thread at the time, or nullptr
+	int panel; // -1 unless the access was made by one of Memory's panel functions
+	int offset;
+	uint32_t size;
+	uint32_t latency; // Nanoseconds
+	uint16_t thread; // Numbered in the order threads first made an access
+	TraceKind kind;
+	bool ok;
+};
+
+// Every traced event with the same tag, added up.
+struct TraceSummary {
+	std::string tag; // Empty for accesses made outside any TraceScope
+	std::array<uint64_t, TRACE_KINDS> count = {};
+	std::array<uint64_t, TRACE_KINDS> bytes = {};
+	uint64_t failed = 0;
+	uint64_t latency = 0; // Nanoseconds, in total
+	std::array<uint64_t, TRACE_LATENCY_BUCKETS> histogram = {};
+};
+
+// Records every read, write, allocation and remote call made in the game, with who made it and how long it took. Recording is off until
+//   enable(true); until then it costs one relaxed atomic load per access. Each thread records into a ring of its own, so recording
+//   doesn't take a lock.
+class MemoryTrace
+{
+public:
+	static void enable(bool on);
+	static bool enabled() { return _enabled.load(std::memory_order_relaxed); }
+	// Drop everything recorded so far.
+	static void clear();
+
+	static uint64_t now();
+	// Called by TracingMemoryBackend. start is from now(), before the access was made.
+	static void record(TraceKind kind, size_t size, uint64_t start, bool ok);
+	static void record(TraceKind kind, int panel, int offset, size_t size, uint64_t start, uint64_t latency, bool ok);
+
+	// Every event still in the rings, in order of time.
+	static std::vector<TraceEvent> events();
+	// The events grouped by tag, busiest (by total latency) first.
+	static std::vector<TraceSummary> summarize();
+	// summarize(), as a table.
+	static std::string report();
+
+private:
+	static std::atomic<bool> _enabled;
+	static std::atomic<int64_t> _start; // steady_clock time of enable(true), in nanoseconds
+};
+
+// Names the code making accesses, for as long as it is in scope. Scopes nest; the innermost one names the accesses. tag must outlive the
+//   trace, which a string literal does.
+class TraceScope
+{
+public:
+	TraceScope(const char* tag);
+	~TraceScope();
+
+	TraceScope(const TraceScope&) = delete;
+	TraceScope& operator=(const TraceScope&) = delete;
+
+private:
+	const char* _previous;
+};
+
+// The panel field this thread's accesses are for, while it is in scope. Set by Memory, so that the trace can tell panels apart.
+class TracePanel
+{
+public:
+	TracePanel(int panel, int offset);
+	~TracePanel();
+
+	TracePanel(const TracePanel&) = delete;
+	TracePanel& operator=(const TracePanel&) = delete;
+
+private:
+	int _previousPanel;
+	int _previousOffset;
+};
+
+// Passes everything through to another backend, recording each access in MemoryTrace while tracing is enabled.
+class TracingMemoryBackend : public MemoryBackend
+{
+public:
+	TracingMemoryBackend(std::unique_ptr<MemoryBackend> backend) : _backend(std::move(backend)) {}
+
+	bool open(const std::string& processName) override { return _backend->open(processName); }
+	void close() override { _backend->close(); }
+	bool isRunning(const std::string& processName) override { return _backend->isRunning(processName); }
+	bool isAlive() override { return _backend->isAlive(); }
+	uintptr_t moduleBase(const std::string& moduleName) override { return _backend->moduleBase(moduleName); }
+	bool read(const void* address, void* buffer, size_t size) override;
+	bool write(void* address, const void* buffer, size_t size) override;
+	using MemoryBackend::read;
+	using MemoryBackend::write;
+	// Each range is recorded as an event of its own, with an even share of the batch's latency.
+	void read(std::vector<MemoryRange>& ranges) override;
+	void write(std::vector<MemoryRange>& ranges) override;
+	void* alloc(size_t size, bool executable) override;
+	bool execute(void* address, bool wait) override;
+	void* handle() override { return _backend->handle(); }
+
+	MemoryBackend* inner() { return _backend.get(); }
+
+private:
+	void recordBatch(TraceKind kind, const std::vector<MemoryRange>& ranges, uint64_t start);
+
+	std::unique_ptr<MemoryBackend> _backend;
+};
@@ -0,0 +1,160 @@
+// This is an open source non-commercial project. Dear PVS-Studio, please check it.
+
+// PVS-Studio Static Code Analyzer for C, C++, C#, and Java: http://www.viva64.com
+
+#include "MemoryWatch.h"
+#include <algorithm>
+
+using std::chrono::nanoseconds;
+
+MemoryWatchRegistry::MemoryWatchRegistry(std::shared_ptr<Memory> memory) : _memory(memory) { }
+
+MemoryWatchRegistry::~MemoryWatchRegistry() {
+	if (_scheduler) _scheduler->cancel(_task);
+}
+
+// Never destroyed, like the scheduler it runs on
+MemoryWatchRegistry& MemoryWatchRegistry::get() {
+	static MemoryWatchRegistry* registry = []() {
+		MemoryWatchRegistry* registry = new MemoryWatchRegistry();
+		registry->start(WatchdogScheduler::get());
+		return registry;
+	}();
+	return *registry;
+}
+
+void MemoryWatchRegistry::start(WatchdogScheduler& scheduler) {
+	_scheduler = &scheduler;
+	_task = scheduler.schedule(std::chrono::milliseconds(MEMORY_WATCH_TICK_MS), [this](nanoseconds&) {
+		sample(_scheduler->now());
+		return true;
+	});
+}
+
+uint64_t MemoryWatchRegistry::watch(int panel, int offset, size_t size, nanoseconds interval, Callback callback, bool initial) {
+	std::lock_guard<std::mutex> lock(_mtx);
+	std::shared_ptr<Watcher> watcher = std::make_shared<Watcher>();
+	watcher->id = _nextId++;
+	watcher->field = FieldKey(panel, offset, size);
+	watcher->interval = std::max(interval, nanoseconds(1));
+	watcher->callback = std::move(callback);
+	watcher->initial = initial;
+	_watchers[watcher->id] = watcher;
+
+	auto search = _fields.find(watcher->field);
+	if (search == _fields.end()) {
+		Field& field = _fields[watcher->field];
+		field.watchers.push_back(watcher);
+		field.interval = watcher->interval;
+	}
+	else {
+		search->second.watchers.push_back(watcher);
+		resetInterval(search->second);
+		// Don't keep it waiting a whole interval for its first value
+		if (initial) search->second.deadline = {};
+	}
+	return watcher->id;
+}
+
+void MemoryWatchRegistry::unwatch(uint64_t id) {
+	std::lock_guard<std::mutex> lock(_mtx);
+	auto search = _watchers.find(id);
+	if (search == _watchers.end()) return;
+	FieldKey key = search->second->field;
+	_watchers.erase(search);
+
+	Field& field = _fields[key];
+	field.watchers.erase(std::remove_if(field.watchers.begin(), field.watchers.end(), [id](const std::shared_ptr<Watcher>& watcher) { return watcher->id == id; }),
+		field.watchers.end());
+	if (field.watchers.empty()) _fields.erase(key);
+	else resetInterval(field);
+}
+
+bool MemoryWatchRegistry::watching(uint64_t id) {
+	std::lock_guard<std::mutex> lock(_mtx);
+	return _watchers.count(id) > 0;
+}
+
+// A watcher joining or leaving can change how often the field is read. A field that now falls due sooner is read at the new interval
+//   from its last read, rather than waiting out the old one.
+void MemoryWatchRegistry::resetInterval(Field& field) {
+	field.interval = field.watchers[0]->interval;
+	for (const std::shared_ptr<Watcher>& watcher : field.watchers) field.interval = std::min(field.interval, watcher->interval);
+	if (field.last.empty()) return;
+	field.deadline = field.lastRead + field.interval;
+}
+
+int MemoryWatchRegistry::sample(nanoseconds now) {
+	std::lock_guard<std::mutex> sampleLock(_sampleMtx);
+
+	std::vector<FieldKey> due;
+	std::vector<std::vector<uint8_t>> buffers;
+	{
+		std::lock_guard<std::mutex> lock(_mtx);
+		for (auto& entry : _fields) {
+			if (entry.second.deadline > now) continue;
+			due.push_back(entry.first);
+			buffers.emplace_back(std::get<2>(entry.first));
+		}
+	}
+	if (due.empty()) return 0;
+
+	std::vector<MemoryRange> ranges;
+	for (size_t i = 0; i < due.size(); i++) ranges.emplace_back(std::get<0>(due[i]), std::get<1>(due[i]), std::get<2>(due[i]), buffers[i].data());
+	try {
+		std::shared_ptr<Memory> memory = _memory ? _memory : Memory::get();
+		memory->ReadBatch(ranges);
+	}
+	catch (std::exception&) {
+		// The game isn't there. Try again next tick, without moving the deadlines.
+		OutputDebugStringW(L"Memory Watch Read Problem");
+		return 0;
+	}
+
+	// Gather the watchers to call while holding the lock, but call them without it, so that they can watch and unwatch
+	std::vector<std::tuple<std::shared_ptr<Watcher>, std::vector<uint8_t>, std::vector<uint8_t>>> notify;
+	int read = 0;
+	{
+		std::lock_guard<std::mutex> lock(_mtx);
+		_stats.samples++;
+		for (size_t i = 0; i < due.size(); i++) {
+			if (!ranges[i].ok) continue;
+			read++;
+			auto search = _fields.find(due[i]);
+			if (search == _fields.end()) continue; // Unwatched during the read
+			Field& field = search->second;
+			field.lastRead = now;
+			field.deadline = now + field.interval;
+			bool changed = !field.last.empty() && field.last != buffers[i];
+			if (changed) _stats.changes++;
+			for (const std::shared_ptr<Watcher>& watcher : field.watchers) {
+				if (changed) notify.emplace_back(watcher, field.last, buffers[i]);
+				else if (watcher->initial) notify.emplace_back(watcher, buffers[i], buffers[i]);
+				watcher->initial = false;
+			}
+			field.last = std::move(buffers[i]);
+		}
+		_stats.fieldsRead += read;
+	}
+
+	for (auto& entry : notify) {
+		const std::shared_ptr<Watcher>& watcher = std::get<0>(entry);
+		if (!watching(watcher->id)) continue; // Unwatched by an earlier callback
+		{
+			std::lock_guard<std::mutex> lock(_mtx);
+			_stats.notifications++;
+		}
+		if (!watcher->callback(std::get<1>(entry), std::get<2>(entry))) unwatch(watcher->id);
+	}
+	return read;
+}
+
+size_t MemoryWatchRegistry::fields() {
+	std::lock_guard<std::mutex> lock(_mtx);
+	return _fields.size();
+}
+
+MemoryWatchStats MemoryWatchRegistry::stats() {
+	std::lock_guard<std::mutex> lock(_mtx);
+	return _stats;
+}
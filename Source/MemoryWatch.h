@@ -0,0 +1,103 @@
+#pragma once
+#include "Memory.h"
+#include "WatchdogScheduler.h"
+#include <chrono>
+#include <cstring>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <tuple>
+#include <type_traits>
+#include <vector>
+
+#define MEMORY_WATCH_TICK_MS 10 // How often the shared registry checks for due fields. Watch intervals are rounded up to this.
+
+// How much the registry has been reading.
+struct MemoryWatchStats {
+	uint64_t samples = 0; // Batched reads sent
+	uint64_t fieldsRead = 0;
+	uint64_t changes = 0; // Times a field was read with different bytes than last time
+	uint64_t notifications = 0; // Callbacks run
+};
+
+// Polls fields of panel entities for whoever wants to know when they change. Watchers of the same field share its reads, and every field
+//   that is due is read in a single batch, so the number of reads grows with the fields being watched instead of with the watchers.
+// A field is read at the shortest interval any of its watchers asked for. The first read only sets the baseline; after that, its watchers
+//   are called whenever a read gives different bytes than the one before. Reads that fail are ignored, so a game that is briefly
+//   unreadable isn't reported as a change.
+class MemoryWatchRegistry
+{
+public:
+	// Called with the field's bytes before and after the change. Returns false to stop watching.
+	using Callback = std::function<bool(const std::vector<uint8_t>& previous, const std::vector<uint8_t>& current)>;
+
+	// Reads through memory, or through the shared session if it is null.
+	MemoryWatchRegistry(std::shared_ptr<Memory> memory = nullptr);
+	~MemoryWatchRegistry();
+
+	MemoryWatchRegistry(const MemoryWatchRegistry&) = delete;
+	MemoryWatchRegistry& operator=(const MemoryWatchRegistry&) = delete;
+
+	// The registry the watchdogs share. It samples on the shared scheduler.
+	static MemoryWatchRegistry& get();
+
+	// Sample every MEMORY_WATCH_TICK_MS on scheduler, until the registry is destroyed. Without this, sample() has to be called by hand.
+	void start(WatchdogScheduler& scheduler);
+
+	// Watch size bytes at offset in panel's entity. Returns the watcher's id. With initial, the watcher is also called with the first value it
+	//   sees, as both previous and current, for watchers that care about a state the field may already be in.
+	uint64_t watch(int panel, int offset, size_t size, std::chrono::nanoseconds interval, Callback callback, bool initial = false);
+	template <class T>
+	uint64_t watch(int panel, const PanelField<T>& field, std::chrono::nanoseconds interval, std::function<bool(typename PanelField<T>::Type previous, typename PanelField<T>::Type current)> callback,
+		bool initial = false) {
+		static_assert(std::is_trivially_copyable<T>::value, "Watched fields are compared byte for byte");
+		return watch(panel, field.offset, sizeof(T), interval, [callback](const std::vector<uint8_t>& previous, const std::vector<uint8_t>& current) {
+			T before, after;
+			std::memcpy(&before, previous.data(), sizeof(T));
+			std::memcpy(&after, current.data(), sizeof(T));
+			return callback(before, after);
+		}, initial);
+	}
+	// Stop a watcher. Its callback may still be running if this is called from another thread.
+	void unwatch(uint64_t id);
+	bool watching(uint64_t id);
+
+	// Read every field that is due at now in one batch, and call the watchers of the ones that changed. Returns the number of fields read.
+	int sample(std::chrono::nanoseconds now);
+
+	// Distinct fields being watched.
+	size_t fields();
+	MemoryWatchStats stats();
+
+private:
+	using FieldKey = std::tuple<int, int, size_t>; // Panel, offset and size
+
+	struct Watcher {
+		uint64_t id;
+		FieldKey field;
+		std::chrono::nanoseconds interval;
+		Callback callback;
+		bool initial; // Still waiting for its first value
+	};
+
+	struct Field {
+		std::vector<std::shared_ptr<Watcher>> watchers;
+		std::chrono::nanoseconds interval; // The shortest of the watchers'
+		std::chrono::nanoseconds lastRead = {};
+		std::chrono::nanoseconds deadline = {}; // When it is next due. Zero until the baseline is read.
+		std::vector<uint8_t> last; // Empty until the baseline is read
+	};
+
+	void resetInterval(Field& field);
+
+	std::shared_ptr<Memory> _memory;
+	std::mutex _sampleMtx; // Only one sample at a time, so that reads of a field are compared in order
+	std::mutex _mtx; // Everything below
+	std::map<FieldKey, Field> _fields;
+	std::map<uint64_t, std::shared_ptr<Watcher>> _watchers;
+	uint64_t _nextId = 1;
+	MemoryWatchStats _stats;
+	WatchdogScheduler* _scheduler = nullptr;
+	uint64_t _task = 0;
+};
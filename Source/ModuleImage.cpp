@@ -0,0 +1,97 @@
+// This is an open source non-commercial project. Dear PVS-Studio, please check it.
+
+// PVS-Studio Static Code Analyzer for C, C++, C#, and Java: http://www.viva64.com
+
+#include "ModuleImage.h"
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+#include <thread>
+
+#define IMAGE_PAGE_SIZE      0x1000 // Granularity of page protections, and so of what can fail to be read.
+#define IMAGE_CHUNK_SIZE   0x100000 // Size of each parallel read. Chunks that fail are retried a page at a time.
+#define IMAGE_MAX_THREADS         8
+#define IMAGE_MAX_SIZE    0x10000000 // Sanity limit on SizeOfImage, so a bad header can't make us allocate gigabytes.
+#define IMAGE_SCN_WRITE   0x80000000 // Section characteristic: the section is writable
+
+template <class T>
+static T get(const std::vector<uint8_t>& data, size_t offset) {
+	T value;
+	std::memcpy(&value, &data[offset], sizeof(T));
+	return value;
+}
+
+bool ModuleImage::load(MemoryBackend& backend, uintptr_t base) {
+	_data.clear();
+	_pages.clear();
+
+	std::vector<uint8_t> headers(IMAGE_PAGE_SIZE);
+	if (!backend.read(base, &headers[0], headers.size()) || headers[0] != 'M' || headers[1] != 'Z') return false;
+	uint32_t pe = get<uint32_t>(headers, 0x3C);
+	if (pe + 0x58 > headers.size() || std::memcmp(&headers[pe], "PE\0\0", 4) != 0) return false;
+	uint16_t numSections = get<uint16_t>(headers, pe + 0x06);
+	uint16_t optionalHeaderSize = get<uint16_t>(headers, pe + 0x14);
+	uint32_t imageSize = get<uint32_t>(headers, pe + 0x50);
+	size_t sectionTable = pe + 0x18 + optionalHeaderSize;
+	if (imageSize < headers.size() || imageSize > IMAGE_MAX_SIZE || sectionTable + numSections * 0x28 > headers.size()) return false;
+
+	_data.resize(imageSize);
+	_pages.resize((imageSize + IMAGE_PAGE_SIZE - 1) / IMAGE_PAGE_SIZE, 0);
+	std::memcpy(&_data[0], &headers[0], headers.size());
+	_pages[0] = true;
+
+	// Split every section into chunks. The gaps between sections aren't mapped, so they aren't read. Writable sections are left out too,
+	//   since a copy of them would go stale.
+	std::vector<std::pair<uint32_t, uint32_t>> chunks;
+	for (int i = 0; i < numSections; i++) {
+		if (get<uint32_t>(headers, sectionTable + i * 0x28 + 0x24) & IMAGE_SCN_WRITE) continue;
+		uint32_t virtualSize = get<uint32_t>(headers, sectionTable + i * 0x28 + 0x08);
+		uint32_t virtualAddress = get<uint32_t>(headers, sectionTable + i * 0x28 + 0x0C);
+		uint32_t end = std::min<uint32_t>(imageSize, virtualAddress + virtualSize);
+		for (uint32_t start = virtualAddress; start < end; start += IMAGE_CHUNK_SIZE) {
+			chunks.push_back({ start, std::min<uint32_t>(IMAGE_CHUNK_SIZE, end - start) });
+		}
+	}
+
+	// Each chunk is written by exactly one thread, and chunks don't share pages unless two sections share one, which the loader doesn't do.
+	std::atomic<size_t> next = 0;
+	auto worker = [&]() {
+		for (size_t i = next++; i < chunks.size(); i = next++) {
+			uint32_t start = chunks[i].first, size = chunks[i].second;
+			if (backend.read(base + start, &_data[start], size)) {
+				for (uint32_t page = start / IMAGE_PAGE_SIZE; page * IMAGE_PAGE_SIZE < start + size; page++) _pages[page] = true;
+				continue;
+			}
+			for (uint32_t page = start / IMAGE_PAGE_SIZE; page * IMAGE_PAGE_SIZE < start + size; page++) {
+				uint32_t pageStart = std::max(start, page * IMAGE_PAGE_SIZE);
+				uint32_t pageSize = std::min(start + size, (page + 1) * IMAGE_PAGE_SIZE) - pageStart;
+				if (backend.read(base + pageStart, &_data[pageStart], pageSize)) _pages[page] = true;
+			}
+		}
+	};
+	size_t numThreads = std::min<size_t>({ chunks.size(), IMAGE_MAX_THREADS, std::max(1u, std::thread::hardware_concurrency()) });
+	std::vector<std::thread> threads;
+	for (size_t i = 1; i < numThreads; i++) threads.emplace_back(worker);
+	worker();
+	for (std::thread& thread : threads) thread.join();
+	return true;
+}
+
+bool ModuleImage::readable(uint64_t rva, size_t size) const {
+	if (rva > _data.size() || size > _data.size() - rva) return false;
+	for (uint64_t page = rva / IMAGE_PAGE_SIZE; page * IMAGE_PAGE_SIZE < rva + size; page++) {
+		if (!_pages[page]) return false;
+	}
+	return true;
+}
+
+bool ModuleImage::read(uint64_t rva, void* buffer, size_t size) const {
+	if (!readable(rva, size)) return false;
+	std::memcpy(buffer, &_data[rva], size);
+	return true;
+}
+
+void ModuleImage::write(uint64_t rva, const void* buffer, size_t size) {
+	if (!readable(rva, size)) return;
+	std::memcpy(&_data[rva], buffer, size);
+}
@@ -0,0 +1,28 @@
+#pragma once
+#include "MemoryBackend.h"
+
+// A local, read-only copy of a module's mapped image, taken once so that signature scans and decoding the game's code don't each read it from
+//   the process again. Offsets into the image are RVAs (addresses relative to the module's base). Pages the process wouldn't let us read are
+//   remembered, and reads that touch them fail like they would against the process. Writable sections aren't copied, and reads of them fail
+//   the same way, so that callers fall back to reading the process's current values.
+class ModuleImage
+{
+public:
+	// Copy the headers and every read-only section of the module at base, reading the sections in parallel chunks. Returns false if the headers
+	//   can't be read or aren't PE headers.
+	bool load(MemoryBackend& backend, uintptr_t base);
+
+	bool loaded() const { return !_data.empty(); }
+	size_t size() const { return _data.size(); }
+
+	// Copy [rva, rva + size) out of the image. Fails if any of it is outside the image or wasn't readable.
+	bool read(uint64_t rva, void* buffer, size_t size) const;
+	// Keep the copy in step with a change made to the process's code.
+	void write(uint64_t rva, const void* buffer, size_t size);
+
+private:
+	bool readable(uint64_t rva, size_t size) const;
+
+	std::vector<uint8_t> _data;
+	std::vector<uint8_t> _pages; // Whether each page was read. Not vector<bool>, since pages are filled in from several threads.
+};
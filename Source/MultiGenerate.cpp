@@ -3,6 +3,7 @@
 // PVS-Studio Static Code Analyzer for C, C++, C#, and Java: http://www.viva64.com
 
 #include "MultiGenerate.h"
+#include <future>
 
 inline Point operator+(const Point& l, const Point& r) { return { l.first + r.first, l.second + r.second }; }
 
@@ -15,14 +16,27 @@ void MultiGenerate::generate(int id, const std::vector<std::shared_ptr<Generate>
 
 bool MultiGenerate::generate(int id, PuzzleSymbols symbols)
 {
+	//Read the panel geometry once and give each generator its own copy, rather than having every generator read the same panel
+	std::shared_ptr<Panel> basePanel;
 	for (std::shared_ptr<Generate> g : generators) {
-		g->initPanel(id);
-		int fails = 0;
-		while (!g->generate_path(symbols)) {
-			if (fails++ > 20)
-				return false;
-		}
+		if (g->_panel) continue;
+		if (!basePanel) basePanel = std::make_shared<Panel>(id);
+		g->_panel = std::make_shared<Panel>(*basePanel);
+	}
+	for (std::shared_ptr<Generate> g : generators) g->initPanel(id);
+
+	//Search for each solution path on its own thread. Seeds are drawn here in generator order, so the result only depends on the current seed.
+	std::vector<std::future<bool>> searches;
+	for (std::shared_ptr<Generate> g : generators) {
+		int seed = Random::rand();
+		searches.push_back(std::async(std::launch::async, &MultiGenerate::generate_path, g, symbols, seed));
+	}
+	bool success = true;
+	for (std::future<bool>& search : searches) {
+		if (!search.get()) success = false;
 	}
+	if (!success)
+		return false;
 
 	std::vector<std::string> solution1; //For debugging only
 	for (int y = 0; y < generators[0]->_panel->_height; y++) {
@@ -65,6 +79,23 @@ bool MultiGenerate::generate(int id, PuzzleSymbols symbols)
 	return true;
 }
 
+//Generate a path for a single generator using its own random stream. Only this generator is retried if it fails.
+bool MultiGenerate::generate_path(std::shared_ptr<Generate> gen, PuzzleSymbols symbols, int seed)
+{
+	std::mt19937 stream(seed);
+	Random::stream = &stream;
+	int fails = 0;
+	bool result = true;
+	while (!gen->generate_path(symbols)) {
+		if (fails++ > 20) { //Give up and let the whole puzzle be restarted, in case this path is impossible with the current setup
+			result = false;
+			break;
+		}
+	}
+	Random::stream = nullptr; //The thread may be reused by another task
+	return result;
+}
+
 bool MultiGenerate::place_all_symbols(PuzzleSymbols symbols)
 {
 	for (std::pair<int, int> s : symbols[Decoration::Stone]) if (!place_stones(s.first & 0xf, s.second))
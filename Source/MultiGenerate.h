@@ -19,6 +19,7 @@ public:
 private:
 
 	bool generate(int id, PuzzleSymbols symbols);
+	static bool generate_path(std::shared_ptr<Generate> gen, PuzzleSymbols symbols, int seed);
 	bool place_all_symbols(PuzzleSymbols symbols);
 	bool can_place_gap(Point pos);
 	bool place_stones(int color, int amount);
@@ -3,6 +3,7 @@
 // PVS-Studio Static Code Analyzer for C, C++, C#, and Java: http://www.viva64.com
 
 #include "Panel.h"
+#include "PanelSchema.h"
 #include "Special.h"
 #include "Memory.h"
 #include "Randomizer.h"
@@ -23,24 +24,26 @@ int find(const std::vector<T> &data, T search, size_t startIndex = 0) {
 }
 
 Panel::Panel() {
-	_memory = std::make_shared<Memory>("witness64_d3d11.exe");
+	_memory = Memory::get();
 }
 
 Panel::Panel(int id) {
-	_memory = std::make_shared<Memory>("witness64_d3d11.exe");
+	_memory = Memory::get();
 	Read(id);
 }
 
 void Panel::Read() {
-	_width = 2 * _memory->ReadPanelData<int>(id, GRID_SIZE_X) - 1;
-	if (_memory->ReadPanelData<int>(id, IS_CYLINDER)) {
+	TraceScope trace("Panel::Read");
+	PanelSnapshot snapshot = _memory->ReadPanelSnapshot(id);
+	_width = 2 * snapshot.get(PanelFields::GridSizeX) - 1;
+	if (snapshot.get(PanelFields::IsCylinder)) {
 		_width++;
 		Point::pillarWidth = _width;
 	}
 	else Point::pillarWidth = 0;
-	_height = 2 * _memory->ReadPanelData<int>(id, GRID_SIZE_Y) - 1;
+	_height = 2 * snapshot.get(PanelFields::GridSizeY) - 1;
 	if (_width <= 0 || _height <= 0 || _width > 30 || _height > 30) {
-		int numIntersections = _memory->ReadPanelData<int>(id, NUM_DOTS);
+		int numIntersections = snapshot.get(PanelFields::NumDots);
 		_width = _height = static_cast<int>(std::round(sqrt(numIntersections))) * 2 - 1;
 	}
 	_grid.resize(_width);
@@ -53,10 +56,8 @@ void Panel::Read() {
 	_startpoints.clear();
 	_endpoints.clear();
 
-	_style = _memory->ReadPanelData<int>(id, STYLE_FLAGS);
-	ReadAllData();
-	ReadIntersections();
-	ReadDecorations();
+	_style = snapshot.get(PanelFields::StyleFlags);
+	ReadAllData(snapshot);
 	pathWidth = 1;
 	_resized = false;
 	colorMode = ColorMode::Default;
@@ -65,6 +66,7 @@ void Panel::Read() {
 }
 
 void Panel::Write() {
+	TraceScope trace("Panel::Write");
 	_memory->WritePanelData<int>(id, GRID_SIZE_X, { (_width + 1) / 2 });
 	_memory->WritePanelData<int>(id, GRID_SIZE_Y, { (_height + 1) / 2 });
 	if (_resized && _memory->ReadPanelData<int>(id, NUM_COLORED_REGIONS) > 0) {
@@ -188,74 +190,35 @@ void Panel::Resize(int width, int height)
 	_resized = true;
 }
 
-void Panel::ReadAllData() {
-	Color pathColor = _memory->ReadPanelData<Color>(id, PATH_COLOR);
-	Color rpathColor = _memory->ReadPanelData<Color>(id, REFLECTION_PATH_COLOR);
-	Color successColor = _memory->ReadPanelData<Color>(id, SUCCESS_COLOR_A);
-	Color strobeColor = _memory->ReadPanelData<Color>(id, STROBE_COLOR_A);
-	Color errorColor = _memory->ReadPanelData<Color>(id, ERROR_COLOR);
-	int numDecorations = _memory->ReadPanelData<int>(id, NUM_DECORATIONS);
-	Color a = _memory->ReadPanelData<Color>(id, SYMBOL_A);
-	Color b = _memory->ReadPanelData<Color>(id, SYMBOL_B);
-	Color c = _memory->ReadPanelData<Color>(id, SYMBOL_C);
-	Color d = _memory->ReadPanelData<Color>(id, SYMBOL_D);
-	Color e = _memory->ReadPanelData<Color>(id, SYMBOL_E);
-	Color ppColor = _memory->ReadPanelData<Color>(id, PATTERN_POINT_COLOR);
-	Color ppColorA = _memory->ReadPanelData<Color>(id, PATTERN_POINT_COLOR_A);
-	Color ppColorB = _memory->ReadPanelData<Color>(id, PATTERN_POINT_COLOR_B);
-	int pushSymbolColors = _memory->ReadPanelData<int>(id, PUSH_SYMBOL_COLORS);
-	int numColored = _memory->ReadPanelData<int>(id, NUM_COLORED_REGIONS);
-	std::vector<int> colored = _memory->ReadArray<int>(id, COLORED_REGIONS, numColored * 4);
-	int numConnections = _memory->ReadPanelData<int>(id, NUM_CONNECTIONS);
-	int numDots = _memory->ReadPanelData<int>(id, NUM_DOTS);
-	int reflectionData = _memory->ReadPanelData<int>(id, REFLECTION_DATA);
-	std::vector<int> rdata; if (reflectionData) rdata = _memory->ReadArray<int>(id, REFLECTION_DATA, numDots);
-	int style = _memory->ReadPanelData<int>(id, STYLE_FLAGS);
-	std::vector<int> connections_a = _memory->ReadArray<int>(id, DOT_CONNECTION_A, numConnections);
-	std::vector<int> connections_b = _memory->ReadArray<int>(id, DOT_CONNECTION_B, numConnections);
-	int numIntersections = _memory->ReadPanelData<int>(id, NUM_DOTS);
-	std::vector<float> intersections = _memory->ReadArray<float>(id, DOT_POSITIONS, numIntersections * 2);
-	std::vector<int> intersectionFlags = _memory->ReadArray<int>(id, DOT_FLAGS, numIntersections);
-	std::vector<int> decorations = _memory->ReadArray<int>(id, DECORATIONS, numDecorations);
-	std::vector<int> decorationFlags = _memory->ReadArray<int>(id, DECORATION_FLAGS, numDecorations);
-	float width = _memory->ReadPanelData<float>(id, PATH_WIDTH_SCALE);
-	int seqLen = _memory->ReadPanelData<int>(id, SEQUENCE_LEN);
-	std::vector<int> seq = _memory->ReadArray<int>(id, SEQUENCE, seqLen);
-	std::vector<float> power = _memory->ReadPanelData<float>(id, POWER, 2);
-	float openRate = _memory->ReadPanelData<float>(id, OPEN_RATE);
-	int cptr = _memory->ReadPanelData<int>(id, DECORATION_COLORS);
-	std::vector<Color> colors; if (cptr) colors = _memory->ReadArray<Color>(id, DECORATION_COLORS, numDecorations);
-	Color outerBackground = _memory->ReadPanelData<Color>(id, OUTER_BACKGROUND);
-	int outerBackgroundMode = _memory->ReadPanelData<int>(id, OUTER_BACKGROUND_MODE);
-	Color bgRegionColor = _memory->ReadPanelData<Color>(id, BACKGROUND_REGION_COLOR);
-	short metadata = _memory->ReadPanelData<short>(id, METADATA);
-	//void* specularTexture = _memory->ReadPanelData<void*>(id, SPECULAR_TEXTURE);
-	//std::vector<float> data = _memory->ReadPanelData<float>(id, SPECULAR_TEXTURE, 1000);
-	int dotSeqLen = _memory->ReadPanelData<int>(id, DOT_SEQUENCE_LEN);
-	std::vector<int> dotSeq = _memory->ReadArray<int>(id, DOT_SEQUENCE, dotSeqLen);
-	int dotSeqLenR = _memory->ReadPanelData<int>(id, DOT_SEQUENCE_LEN_REFLECTION);
-	std::vector<int> dotSeqR = _memory->ReadArray<int>(id, DOT_SEQUENCE_REFLECTION, dotSeqLenR);
-	void* target = _memory->ReadPanelData<void*>(id, TARGET);
-	void* panelTarget = _memory->ReadPanelData<void*>(id, PANEL_TARGET);
-	Color cableTarget = _memory->ReadPanelData<Color>(id, CABLE_TARGET_2);
-	//std::vector<int> targets = _memory->ReadArray<int>(id, PANEL_TARGET, 6);
-	int isPillar = _memory->ReadPanelData<int>(id, IS_CYLINDER);
-	int numTraced = _memory->ReadPanelData<int>(id, TRACED_EDGES);
-	int numSol = _memory->ReadPanelData<int>(id, TRACED_EDGES + 4); //Don't know what this number is for yet
-	int tracedptr = _memory->ReadPanelData<int>(id, TRACED_EDGE_DATA);
-	//float solved = _memory->ReadPanelData<float>(id, SOLVED);
-	float distance = _memory->ReadPanelData<float>(id, MAX_BROADCAST_DISTANCE);
-	std::vector<SolutionPoint> traced; if (tracedptr) traced = _memory->ReadArray<SolutionPoint>(id, TRACED_EDGE_DATA, numTraced);
+void Panel::ReadAllData(PanelSnapshot& snapshot) {
+	PanelArrays arrays;
+	snapshot.queueArray(PanelFields::DotPositions, arrays.intersections);
+	snapshot.queueArray(PanelFields::DotFlags, arrays.intersectionFlags);
+	snapshot.queueArray(PanelFields::ReflectionData, arrays.symmetryData);
+	snapshot.queueArray(PanelFields::DotConnectionA, arrays.connections_a);
+	snapshot.queueArray(PanelFields::DotConnectionB, arrays.connections_b);
+	snapshot.queueArray(PanelFields::Decorations, arrays.decorations);
+	//The rest aren't used here, but reading them records their sizes, so that writing them later only reallocates if they grow
+	std::vector<int> decorationFlags, colored, seq, dotSeq, dotSeqR;
+	std::vector<Color> colors;
+	std::vector<SolutionPoint> traced;
+	snapshot.queueArray(PanelFields::DecorationFlags, decorationFlags);
+	snapshot.queueArray(PanelFields::DecorationColors, colors);
+	snapshot.queueArray(PanelFields::ColoredRegions, colored);
+	snapshot.queueArray(PanelFields::Sequence, seq);
+	snapshot.queueArray(PanelFields::DotSequence, dotSeq);
+	snapshot.queueArray(PanelFields::DotSequenceReflection, dotSeqR);
+	snapshot.queueArray(PanelFields::TracedEdgeData, traced);
+	_memory->ReadArrays(snapshot);
+
+	ReadIntersections(arrays);
+	ReadDecorations(arrays);
 }
 
-void Panel::ReadDecorations() {
-	int numDecorations = _memory->ReadPanelData<int>(id, NUM_DECORATIONS);
-	std::vector<int> decorations = _memory->ReadArray<int>(id, DECORATIONS, numDecorations);
-	std::vector<int> decorationFlags = _memory->ReadArray<int>(id, DECORATION_FLAGS, numDecorations);
-
-	for (int i=0; i<numDecorations; i++) {
+void Panel::ReadDecorations(const PanelArrays& arrays) {
+	for (int i=0; i<arrays.decorations.size(); i++) {
 		auto [x, y] = dloc_to_xy(i);
-		_grid[x][y] = decorations[i];
+		_grid[x][y] = arrays.decorations[i];
 	}
 }
 
@@ -346,13 +309,13 @@ void Panel::StartArrowWatchdogs(const std::map<int, int>& shuffleMappings) {
 		if (invertedMappings.count(realId)) realId = invertedMappings.at(realId);
 
 		ArrowWatchdog* watchdog = new ArrowWatchdog(realId, pillarWidth);
-		watchdog->start();
+		watchdog->watch();
 	}
 }
 
-void Panel::ReadIntersections() {
-	int numIntersections = _memory->ReadPanelData<int>(id, NUM_DOTS);
-	std::vector<float> intersections = _memory->ReadArray<float>(id, DOT_POSITIONS, numIntersections * 2);
+void Panel::ReadIntersections(const PanelArrays& arrays) {
+	int numIntersections = static_cast<int>(arrays.intersectionFlags.size());
+	const std::vector<float>& intersections = arrays.intersections;
 	int num_grid_points = this->get_num_grid_points();
 	minx = intersections[0]; miny = intersections[1];
 	maxx = intersections[num_grid_points * 2 - 2]; maxy = intersections[num_grid_points * 2 - 1];
@@ -361,9 +324,8 @@ void Panel::ReadIntersections() {
 	unitWidth = (maxx - minx) / (_width - 1);
 	if (Point::pillarWidth) unitWidth = 1.0f / _width;
 	unitHeight = (maxy - miny) / (_height - 1);
-	std::vector<int> intersectionFlags = _memory->ReadArray<int>(id, DOT_FLAGS, numIntersections);
-	std::vector<int> symmetryData = _memory->ReadPanelData<int>(id, REFLECTION_DATA) ? 
-		_memory->ReadArray<int>(id, REFLECTION_DATA, numIntersections) : std::vector<int>();
+	const std::vector<int>& intersectionFlags = arrays.intersectionFlags;
+	const std::vector<int>& symmetryData = arrays.symmetryData;
 	if (symmetryData.size() == 0) symmetry = Symmetry::None;
 	else if (symmetryData[0] == num_grid_points - 1) symmetry = Symmetry::Rotational;
 	else if (symmetryData[0] == _width / 2 && intersections[1] == intersections[3]) symmetry = Symmetry::Vertical;
@@ -384,9 +346,9 @@ void Panel::ReadIntersections() {
 			_grid[x][y] = OPEN;
 		}
 	}
-	int numConnections = _memory->ReadPanelData<int>(id, NUM_CONNECTIONS);
-	std::vector<int> connections_a = _memory->ReadArray<int>(id, DOT_CONNECTION_A, numConnections);
-	std::vector<int> connections_b = _memory->ReadArray<int>(id, DOT_CONNECTION_B, numConnections);
+	int numConnections = static_cast<int>(arrays.connections_a.size());
+	const std::vector<int>& connections_a = arrays.connections_a;
+	const std::vector<int>& connections_b = arrays.connections_b;
 	//Remove non-existent connections
 	std::vector<std::string> out;
 	for (int i = 0; i < connections_a.size(); i++) {
@@ -179,10 +179,20 @@ public:
 
 private:
 
-	void ReadAllData();
-	void ReadIntersections();
+	//Arrays read from the game in ReadAllData
+	struct PanelArrays {
+		std::vector<float> intersections;
+		std::vector<int> intersectionFlags;
+		std::vector<int> symmetryData;
+		std::vector<int> connections_a;
+		std::vector<int> connections_b;
+		std::vector<int> decorations;
+	};
+
+	void ReadAllData(PanelSnapshot& snapshot);
+	void ReadIntersections(const PanelArrays& arrays);
 	void WriteIntersections();
-	void ReadDecorations();
+	void ReadDecorations(const PanelArrays& arrays);
 	void WriteDecorations();
 
 	Point get_sym_point(int x, int y, Symmetry symmetry)
@@ -0,0 +1,74 @@
+#pragma once
+#include "Panel.h"
+
+// The fields of a panel's entity, with the type each one holds and, for the arrays, which field holds their length. Use these with
+//   Memory's and PanelSnapshot's field overloads instead of picking a type and reading the length at every call site.
+namespace PanelFields
+{
+	constexpr PanelField<float> Position = { POSITION, 3 };
+	constexpr PanelField<float> Scale = { SCALE };
+	constexpr PanelField<float> Orientation = { ORIENTATION, 4 };
+	constexpr PanelField<float> PathColor = { PATH_COLOR, 4 };
+	constexpr PanelField<float> ReflectionPathColor = { REFLECTION_PATH_COLOR, 4 };
+	constexpr PanelField<float> DotColor = { DOT_COLOR, 4 };
+	constexpr PanelField<float> ActiveColor = { ACTIVE_COLOR, 4 };
+	constexpr PanelField<float> BackgroundRegionColor = { BACKGROUND_REGION_COLOR, 4 };
+	constexpr PanelField<float> SuccessColorA = { SUCCESS_COLOR_A, 4 };
+	constexpr PanelField<float> SuccessColorB = { SUCCESS_COLOR_B, 4 };
+	constexpr PanelField<float> StrobeColorA = { STROBE_COLOR_A, 4 };
+	constexpr PanelField<float> StrobeColorB = { STROBE_COLOR_B, 4 };
+	constexpr PanelField<float> ErrorColor = { ERROR_COLOR, 4 };
+	constexpr PanelField<float> PatternPointColor = { PATTERN_POINT_COLOR, 4 };
+	constexpr PanelField<float> PatternPointColorA = { PATTERN_POINT_COLOR_A, 4 };
+	constexpr PanelField<float> PatternPointColorB = { PATTERN_POINT_COLOR_B, 4 };
+	constexpr PanelField<float> SymbolA = { SYMBOL_A, 4 };
+	constexpr PanelField<float> SymbolB = { SYMBOL_B, 4 };
+	constexpr PanelField<float> SymbolC = { SYMBOL_C, 4 };
+	constexpr PanelField<float> SymbolD = { SYMBOL_D, 4 };
+	constexpr PanelField<float> SymbolE = { SYMBOL_E, 4 };
+	constexpr PanelField<int> PushSymbolColors = { PUSH_SYMBOL_COLORS };
+	constexpr PanelField<float> OuterBackground = { OUTER_BACKGROUND, 4 };
+	constexpr PanelField<int> OuterBackgroundMode = { OUTER_BACKGROUND_MODE };
+	constexpr PanelField<int> TracedEdges = { TRACED_EDGES };
+	constexpr PanelField<int> FlashMode = { FLASH_MODE };
+	constexpr PanelField<int> Solved = { SOLVED };
+	constexpr PanelField<float> Power = { POWER, 2 };
+	constexpr PanelField<int> Target = { TARGET };
+	constexpr PanelField<int> PowerOffOnFail = { POWER_OFF_ON_FAIL };
+	constexpr PanelField<int> IsCylinder = { IS_CYLINDER };
+	constexpr PanelField<float> CylinderZ0 = { CYLINDER_Z0 };
+	constexpr PanelField<float> CylinderZ1 = { CYLINDER_Z1 };
+	constexpr PanelField<float> CylinderRadius = { CYLINDER_RADIUS };
+	constexpr PanelField<float> PatternScale = { PATTERN_SCALE };
+	constexpr PanelField<float> CursorSpeedScale = { CURSOR_SPEED_SCALE };
+	constexpr PanelField<int> NeedsRedraw = { NEEDS_REDRAW };
+	constexpr PanelField<float> SpecularAdd = { SPECULAR_ADD };
+	constexpr PanelField<float> SpecularPower = { SPECULAR_POWER };
+	constexpr PanelField<float> PathWidthScale = { PATH_WIDTH_SCALE };
+	constexpr PanelField<float> StartpointScale = { STARTPOINT_SCALE };
+	constexpr PanelField<int> NumDots = { NUM_DOTS };
+	constexpr PanelField<int> NumConnections = { NUM_CONNECTIONS };
+	constexpr PanelField<float> MaxBroadcastDistance = { MAX_BROADCAST_DISTANCE };
+	constexpr PanelField<int> NumDecorations = { NUM_DECORATIONS };
+	constexpr PanelField<int> GridSizeX = { GRID_SIZE_X };
+	constexpr PanelField<int> GridSizeY = { GRID_SIZE_Y };
+	constexpr PanelField<int> StyleFlags = { STYLE_FLAGS };
+	constexpr PanelField<int> SequenceLength = { SEQUENCE_LEN };
+	constexpr PanelField<int> DotSequenceLength = { DOT_SEQUENCE_LEN };
+	constexpr PanelField<int> DotSequenceLengthReflection = { DOT_SEQUENCE_LEN_REFLECTION };
+	constexpr PanelField<int> NumColoredRegions = { NUM_COLORED_REGIONS };
+
+	constexpr PanelArrayField<SolutionPoint> TracedEdgeData = { TRACED_EDGE_DATA, TracedEdges, 1, true };
+	constexpr PanelArrayField<float> DotPositions = { DOT_POSITIONS, NumDots, 2 }; // x and y of each dot
+	constexpr PanelArrayField<int> DotFlags = { DOT_FLAGS, NumDots };
+	constexpr PanelArrayField<int> DotConnectionA = { DOT_CONNECTION_A, NumConnections };
+	constexpr PanelArrayField<int> DotConnectionB = { DOT_CONNECTION_B, NumConnections };
+	constexpr PanelArrayField<int> Decorations = { DECORATIONS, NumDecorations };
+	constexpr PanelArrayField<int> DecorationFlags = { DECORATION_FLAGS, NumDecorations };
+	constexpr PanelArrayField<Color> DecorationColors = { DECORATION_COLORS, NumDecorations, 1, true };
+	constexpr PanelArrayField<int> ReflectionData = { REFLECTION_DATA, NumDots, 1, true }; // The dot each dot is mirrored to
+	constexpr PanelArrayField<int> Sequence = { SEQUENCE, SequenceLength };
+	constexpr PanelArrayField<int> DotSequence = { DOT_SEQUENCE, DotSequenceLength };
+	constexpr PanelArrayField<int> DotSequenceReflection = { DOT_SEQUENCE_REFLECTION, DotSequenceLengthReflection };
+	constexpr PanelArrayField<int> ColoredRegions = { COLORED_REGIONS, NumColoredRegions, 4 };
+}
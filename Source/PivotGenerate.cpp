@@ -0,0 +1,164 @@
+// This is an open source non-commercial project. Dear PVS-Studio, please check it.
+
+// PVS-Studio Static Code Analyzer for C, C++, C#, and Java: http://www.viva64.com
+
+#include "PivotGenerate.h"
+#include <chrono>
+#include <algorithm>
+
+#define PIVOT_POOL_SIZE 16 // Number of candidate paths made for each exit per search round.
+#define PIVOT_PATH_STEPS 5000 // Number of steps a single path search may take before giving up.
+
+static const int DIRECTIONS[4][2] = { { 0, 2 }, { 0, -2 }, { 2, 0 }, { -2, 0 } };
+
+PivotGenerate::PivotGenerate(int width, int height, Point start, const std::vector<Point>& exits)
+{
+	_width = width;
+	_height = height;
+	_start = index(start.first, start.second);
+	for (Point p : exits) _exits.push_back(index(p.first, p.second));
+	_minLength = ((width + 1) / 2) * ((height + 1) / 2) * 3 / 4; //Same default path length as Generate::generate_path
+}
+
+bool PivotGenerate::generate(const std::vector<std::pair<int, int>>& symbolVec, int timeLimit)
+{
+	int amount = 0;
+	for (std::pair<int, int> s : symbolVec) {
+		if ((s.first & 0x700) != Decoration::Triangle)
+			return false;
+		amount += s.second;
+	}
+	std::vector<int> blocks;
+	for (int x = 1; x < _width; x += 2) {
+		for (int y = 1; y < _height; y += 2) {
+			blocks.push_back(index(x, y));
+		}
+	}
+	auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(timeLimit);
+	while (std::chrono::steady_clock::now() < deadline) {
+		//Make a fresh pool of candidate paths for every exit, then look for one path per exit that leaves enough blocks where all of them agree
+		std::vector<std::vector<Candidate>> pools(_exits.size());
+		bool empty = false;
+		for (int i = 0; i < _exits.size() && !empty; i++) {
+			for (int j = 0; j < PIVOT_POOL_SIZE; j++) {
+				Candidate candidate;
+				if (random_path(i, candidate)) pools[i].push_back(candidate);
+			}
+			empty = (pools[i].size() == 0);
+		}
+		if (empty) continue;
+		std::vector<int> chosen;
+		if (search(pools, 0, blocks, chosen, symbolVec, amount)) {
+			paths.clear();
+			for (int i = 0; i < chosen.size(); i++) paths.push_back(pools[i][chosen[i]].path);
+			return true;
+		}
+	}
+	return false;
+}
+
+//Make a random path from the start to the given exit. Returns false if the search ran out of steps.
+bool PivotGenerate::random_path(int exit, Candidate& candidate)
+{
+	std::vector<bool> visited(_width * _height, false);
+	int steps = 0;
+	candidate.path.clear();
+	if (!search_path(_start % _width, _start / _width, _exits[exit], candidate.path, visited, steps))
+		return false;
+	count_sides(candidate);
+	return true;
+}
+
+//Randomized depth-first search for a path of at least the minimum length. The path may not pass through its own exit before the end.
+bool PivotGenerate::search_path(int x, int y, int exit, std::vector<int>& path, std::vector<bool>& visited, int& steps)
+{
+	int pos = index(x, y);
+	visited[pos] = true;
+	path.push_back(pos);
+	if (pos == exit) {
+		if ((path.size() + 1) / 2 >= _minLength)
+			return true;
+	}
+	else if (steps++ < PIVOT_PATH_STEPS) {
+		int order[4] = { 0, 1, 2, 3 };
+		for (int i = 3; i > 0; i--) std::swap(order[i], order[Random::rand() % (i + 1)]);
+		for (int dir : order) {
+			int nx = x + DIRECTIONS[dir][0], ny = y + DIRECTIONS[dir][1];
+			if (off_edge(nx, ny) || visited[index(nx, ny)]) continue;
+			path.push_back(index(x + DIRECTIONS[dir][0] / 2, y + DIRECTIONS[dir][1] / 2));
+			if (search_path(nx, ny, exit, path, visited, steps))
+				return true;
+			path.pop_back();
+		}
+	}
+	visited[pos] = false;
+	path.pop_back();
+	return false;
+}
+
+//Count how many sides of each grid block are touched by the path (for the triangles)
+void PivotGenerate::count_sides(Candidate& candidate)
+{
+	candidate.sides = std::vector<int>(_width * _height, 0);
+	for (int pos : candidate.path) {
+		int x = pos % _width, y = pos / _width;
+		if (x % 2 == 1 && y % 2 == 0) { //Horizontal line segment
+			if (y > 0) candidate.sides[index(x, y - 1)]++;
+			if (y + 1 < _height) candidate.sides[index(x, y + 1)]++;
+		}
+		else if (x % 2 == 0 && y % 2 == 1) { //Vertical line segment
+			if (x > 0) candidate.sides[index(x - 1, y)]++;
+			if (x + 1 < _width) candidate.sides[index(x + 1, y)]++;
+		}
+	}
+}
+
+//Pick a path for each exit in turn. After each pick, only the blocks where the new path agrees with the previous ones stay open,
+//so combinations that can't fit all the triangles are cut off as early as possible.
+bool PivotGenerate::search(const std::vector<std::vector<Candidate>>& pools, int depth, const std::vector<int>& open, std::vector<int>& chosen,
+	const std::vector<std::pair<int, int>>& symbolVec, int amount)
+{
+	if (depth == pools.size())
+		return place_triangles(open, pools[0][chosen[0]], symbolVec);
+	std::vector<int> order;
+	for (int i = 0; i < pools[depth].size(); i++) order.push_back(i);
+	while (order.size() > 0) {
+		int i = pop_random(order);
+		const Candidate& candidate = pools[depth][i];
+		std::vector<int> narrowed;
+		for (int block : open) {
+			int sides = candidate.sides[block];
+			if (sides == 0 || sides == 4) continue;
+			if (depth > 0 && sides != pools[0][chosen[0]].sides[block]) continue;
+			narrowed.push_back(block);
+		}
+		if (narrowed.size() < amount) continue;
+		chosen.push_back(i);
+		if (search(pools, depth + 1, narrowed, chosen, symbolVec, amount))
+			return true;
+		chosen.pop_back();
+	}
+	return false;
+}
+
+//Place the triangles on the blocks that every chosen path agrees on
+bool PivotGenerate::place_triangles(const std::vector<int>& open, const Candidate& reference, const std::vector<std::pair<int, int>>& symbolVec)
+{
+	std::vector<int> available = open;
+	grid = std::vector<std::vector<int>>(_width, std::vector<int>(_height, 0));
+	for (std::pair<int, int> s : symbolVec) {
+		int targetCount = s.first >> 16;
+		for (int i = 0; i < s.second; i++) {
+			std::vector<int> valid;
+			for (int block : available) {
+				if (!targetCount || reference.sides[block] == targetCount) valid.push_back(block);
+			}
+			if (valid.size() == 0)
+				return false;
+			int block = pop_random(valid);
+			available.erase(std::find(available.begin(), available.end(), block));
+			grid[block % _width][block / _width] = Decoration::Triangle | (reference.sides[block] << 16) | (s.first & 0xf);
+		}
+	}
+	return true;
+}
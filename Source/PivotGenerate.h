@@ -0,0 +1,43 @@
+#pragma once
+#include "Panel.h"
+#include "Random.h"
+#include <vector>
+
+//Class for generating pivot puzzles. A pivot puzzle must be solvable to every one of its exits, so the solution paths for all exits are searched for
+//together, and symbols are only placed where every solution agrees on them.
+class PivotGenerate
+{
+public:
+
+	PivotGenerate(int width, int height, Point start, const std::vector<Point>& exits);
+
+	//Try to find a solution path for each exit and a symbol layout that all of them satisfy. Only triangles are supported.
+	//timeLimit - how long to search for, in milliseconds. Returns false if no layout was found in that time.
+	bool generate(const std::vector<std::pair<int, int>>& symbolVec, int timeLimit);
+
+	std::vector<std::vector<int>> grid; //The symbols that were placed, indexed by [x][y]
+	std::vector<std::vector<int>> paths; //The solution path for each exit, as a list of grid indices
+
+private:
+
+	struct Candidate {
+		std::vector<int> path;
+		std::vector<int> sides; //Number of sides of each grid block touched by the path
+	};
+
+	int index(int x, int y) { return x + y * _width; }
+	bool off_edge(int x, int y) { return x < 0 || x >= _width || y < 0 || y >= _height; }
+	bool random_path(int exit, Candidate& candidate);
+	bool search_path(int x, int y, int exit, std::vector<int>& path, std::vector<bool>& visited, int& steps);
+	void count_sides(Candidate& candidate);
+	bool search(const std::vector<std::vector<Candidate>>& pools, int depth, const std::vector<int>& open, std::vector<int>& chosen,
+		const std::vector<std::pair<int, int>>& symbolVec, int amount);
+	bool place_triangles(const std::vector<int>& open, const Candidate& reference, const std::vector<std::pair<int, int>>& symbolVec);
+
+	template <class T> T pop_random(std::vector<T>& vec) { int i = Random::rand() % vec.size(); T item = vec[i]; vec.erase(vec.begin() + i); return item; }
+
+	int _width, _height;
+	int _start;
+	std::vector<int> _exits;
+	int _minLength;
+};
@@ -0,0 +1,88 @@
+// This is an open source non-commercial project. Dear PVS-Studio, please check it.
+
+// PVS-Studio Static Code Analyzer for C, C++, C#, and Java: http://www.viva64.com
+
+#include "ProgressChannel.h"
+#include <algorithm>
+#include <string>
+
+std::wstring ProgressEvent::text() const
+{
+	std::wstring text = phase;
+	if (total == 0) return text;
+	text += L": " + std::to_wstring(done) + L"/" + std::to_wstring(total);
+	if (percent >= 0) text += L" (" + std::to_wstring(percent) + L"%)";
+	return text;
+}
+
+bool ProgressQueue::push(const ProgressEvent& event)
+{
+	size_t head = _head.load(std::memory_order_relaxed);
+	if (head - _tail.load(std::memory_order_acquire) == PROGRESS_QUEUE_SIZE) {
+		_dropped.fetch_add(1, std::memory_order_relaxed);
+		return false;
+	}
+	_events[head & (PROGRESS_QUEUE_SIZE - 1)] = event;
+	_head.store(head + 1, std::memory_order_release);
+	return true;
+}
+
+bool ProgressQueue::pop(ProgressEvent& event)
+{
+	size_t tail = _tail.load(std::memory_order_relaxed);
+	if (tail == _head.load(std::memory_order_acquire))
+		return false;
+	event = _events[tail & (PROGRESS_QUEUE_SIZE - 1)];
+	_tail.store(tail + 1, std::memory_order_release);
+	return true;
+}
+
+std::shared_ptr<ProgressChannel> ProgressChannel::get()
+{
+	static std::shared_ptr<ProgressChannel> channel = std::make_shared<ProgressChannel>();
+	return channel;
+}
+
+ProgressQueue* ProgressChannel::subscribe()
+{
+	std::lock_guard<std::mutex> lock(_mtx);
+	for (int i = 0; i < PROGRESS_MAX_SUBSCRIBERS; i++) {
+		if (_active[i].load(std::memory_order_relaxed)) continue;
+		//Skip anything left over from the previous subscriber
+		_queues[i]._tail.store(_queues[i]._head.load(std::memory_order_acquire), std::memory_order_release);
+		_queues[i]._dropped.store(0, std::memory_order_relaxed);
+		_active[i].store(true, std::memory_order_release);
+		return &_queues[i];
+	}
+	return nullptr;
+}
+
+void ProgressChannel::unsubscribe(ProgressQueue* queue)
+{
+	std::lock_guard<std::mutex> lock(_mtx);
+	for (int i = 0; i < PROGRESS_MAX_SUBSCRIBERS; i++) {
+		if (&_queues[i] == queue) _active[i].store(false, std::memory_order_release);
+	}
+}
+
+void ProgressChannel::start()
+{
+	_start = std::chrono::steady_clock::now();
+}
+
+void ProgressChannel::publish(const std::wstring& phase, int panel, int attempts, int done, int total, int percent)
+{
+	ProgressEvent event;
+	size_t length = std::min(phase.size(), sizeof(event.phase) / sizeof(wchar_t) - 1);
+	std::char_traits<wchar_t>::copy(event.phase, phase.c_str(), length);
+	event.phase[length] = 0;
+	event.panel = panel;
+	event.attempts = attempts;
+	event.done = done;
+	event.total = total;
+	event.percent = percent;
+	event.elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - _start).count();
+	for (int i = 0; i < PROGRESS_MAX_SUBSCRIBERS; i++) {
+		if (_active[i].load(std::memory_order_acquire)) _queues[i].push(event);
+	}
+}
@@ -0,0 +1,62 @@
+#pragma once
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <mutex>
+#include <string>
+
+#define PROGRESS_QUEUE_SIZE 256 // Number of events a subscriber can fall behind by before new events are dropped. Must be a power of two.
+#define PROGRESS_MAX_SUBSCRIBERS 8 // Maximum number of subscribers at once.
+
+//One progress update from the puzzle generator
+struct ProgressEvent {
+	wchar_t phase[48]; //Name of the area or step in progress
+	int panel; //Id of the panel that was just finished, or 0 if this is only a phase change
+	int attempts; //Number of generation attempts the panel took
+	int done, total; //Number of puzzles finished in this phase, out of total (0 if not counted)
+	int percent; //Progress through the whole run, or -1 if not known
+	long long elapsed; //Milliseconds since the run started
+
+	//The text for the loading indicator, e.g. "Tutorial: 3/21 (5%)"
+	std::wstring text() const;
+};
+
+//Lock-free queue between the generation thread and one subscriber. The generator never waits on it; if it is full, events are dropped.
+class ProgressQueue
+{
+public:
+	bool push(const ProgressEvent& event);
+	bool pop(ProgressEvent& event);
+	int dropped() { return _dropped.load(std::memory_order_relaxed); }
+
+private:
+	ProgressEvent _events[PROGRESS_QUEUE_SIZE];
+	std::atomic<size_t> _head = 0; //Next slot to write. Only changed by the producer.
+	std::atomic<size_t> _tail = 0; //Next slot to read. Only changed by the consumer.
+	std::atomic<int> _dropped = 0;
+
+	friend class ProgressChannel;
+};
+
+//Sends generation progress to any number of subscribers (the loading text in the window, a command line, benchmarks), each of which reads
+//its own queue at its own pace. There is a single producer: the thread that is generating the puzzles.
+class ProgressChannel
+{
+public:
+	static std::shared_ptr<ProgressChannel> get();
+
+	//Returns a queue to read events from. It stays valid until unsubscribe is called, and is reused for later subscribers after that.
+	ProgressQueue* subscribe();
+	void unsubscribe(ProgressQueue* queue);
+
+	//Start timing a new run. Called from the generation thread.
+	void start();
+	void publish(const std::wstring& phase) { publish(phase, 0, 0, 0, 0, -1); }
+	void publish(const std::wstring& phase, int panel, int attempts, int done, int total, int percent);
+
+private:
+	ProgressQueue _queues[PROGRESS_MAX_SUBSCRIBERS];
+	std::atomic<bool> _active[PROGRESS_MAX_SUBSCRIBERS] = {};
+	std::mutex _mtx; //Only used to hand out queues. Publishing doesn't take it.
+	std::chrono::steady_clock::time_point _start = std::chrono::steady_clock::now();
+};
@@ -4,9 +4,12 @@
 
 #include "PuzzleList.h"
 #include "Watchdog.h"
+#include "MemoryWatch.h"
+#include "PanelSchema.h"
 
 void PuzzleList::GenerateAllN()
 {
+	ProgressChannel::get()->start();
 	generator->setLoadingData(336);
 	CopyTargets();
 	GenerateTutorialN();
@@ -24,7 +27,7 @@ void PuzzleList::GenerateAllN()
 	GenerateJungleN();
 	GenerateMountainN();
 	GenerateCavesN();
-	SetWindowText(_handle, L"Done!");
+	ProgressChannel::get()->publish(L"Done!");
 	(new ArrowWatchdog(0x0056E))->start(); //Easy way to close the randomizer when the game is done
 	//GenerateShadowsN(); //Can't randomize
 	//GenerateMonasteryN(); //Can't randomize
@@ -34,7 +37,7 @@ void PuzzleList::GenerateShadowsN() {
 	generator->setLoadingData(L"Shadows", 13);
 	generator->resetConfig();
 
-	std::shared_ptr<Memory> _memory = std::make_shared<Memory>("witness64_d3d11.exe");
+	std::shared_ptr<Memory> _memory = Memory::get();
 
 	_memory->WritePanelData<int>(0x386FA, SEQUENCE_LEN , { 0 });
 	_memory->WritePanelData<int>(0x386FA, DOT_SEQUENCE_LEN, { 0 });
@@ -57,6 +60,7 @@ void PuzzleList::GenerateShadowsN() {
 
 void PuzzleList::GenerateAllH()
 {
+	ProgressChannel::get()->start();
 	generator->setLoadingData(349);
 	CopyTargets();
 	GenerateTutorialH();
@@ -74,7 +78,7 @@ void PuzzleList::GenerateAllH()
 	GenerateJungleH();
 	GenerateMountainH();
 	GenerateCavesH();
-	SetWindowText(_handle, L"Done!");
+	ProgressChannel::get()->publish(L"Done!");
 	//GenerateShadowsH(); //Can't randomize
 	//GenerateMonasteryH(); //Can't randomize
 }
@@ -697,8 +701,7 @@ void PuzzleList::GenerateTrianglePanelsN()
 
 void PuzzleList::GenerateMountainN()
 {
-	std::wstring text = L"Mountain Perspective";
-	SetWindowText(_handle, text.c_str());
+	ProgressChannel::get()->publish(L"Mountain Perspective");
 	specialCase->generateMountaintop(0x17C34, { { Decoration::Stone | Decoration::Color::Black, 2 },{ Decoration::Stone | Decoration::Color::White, 1, },
 		{ Decoration::Star | Decoration::Color::Black, 1, },{ Decoration::Star | Decoration::Color::White, 1 } });
 	
@@ -1685,7 +1688,19 @@ void PuzzleList::GenerateTreehouseH()
 		Decoration::Stone | Decoration::Color::Black, 1, Decoration::Stone | Decoration::Color::White, 1,
 		Decoration::Poly | Decoration::Can_Rotate | Decoration::Black, 1, Decoration::Poly | Decoration::Can_Rotate | Decoration::White, 1,
 		Decoration::Triangle | Decoration::Black, 1, Decoration::Triangle | Decoration::White, 1);
-	(new TreehouseWatchdog(0x17DAE))->start();
+	//Turn on the door panel once the bridge panel before it is solved
+	MemoryWatchRegistry::get().watch(0x03613, PanelFields::Solved, std::chrono::seconds(1), [](int, int solved) {
+		if (!solved) return true;
+		try {
+			std::shared_ptr<Memory> memory = Memory::get();
+			memory->WritePanelData<float>(0x17DAE, POWER, { 1.0f, 1.0f });
+			memory->WritePanelData<int>(0x17DAE, NEEDS_REDRAW, { 1 });
+		}
+		catch (std::exception&) {
+			OutputDebugStringW(L"Watchdog Write Problem");
+		}
+		return false;
+	}, true);
 	//Orange Bridge 2
 	generator->setFlag(Generate::Config::TreehouseColors);
 	generator->pathWidth = 1;
@@ -1894,8 +1909,7 @@ void PuzzleList::GenerateTrianglePanelsH()
 
 void PuzzleList::GenerateMountainH()
 {
-	std::wstring text = L"Mountain Perspective";
-	SetWindowText(_handle, text.c_str());
+	ProgressChannel::get()->publish(L"Mountain Perspective");
 	specialCase->generateMountaintop(0x17C34, {
 		{ Decoration::Triangle | Decoration::Color::White, 2 },{ Decoration::Triangle | Decoration::Color::Black, 1 },
 		{ Decoration::Star | Decoration::Color::White, 1 },{ Decoration::Star | Decoration::Color::Black, 1 },
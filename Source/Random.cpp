@@ -5,4 +5,5 @@
 #include "Random.h"
 #include <time.h>
 
-std::mt19937 Random::gen = std::mt19937((int)time(0));
\ No newline at end of file
+std::mt19937 Random::gen = std::mt19937((int)time(0));
+thread_local std::mt19937* Random::stream = nullptr;
\ No newline at end of file
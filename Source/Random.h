@@ -5,12 +5,14 @@
 struct Random {
 
 	static std::mt19937 gen;
+	static thread_local std::mt19937* stream; //If set, rand() draws from this stream instead of gen. Used to give worker threads independent random streams.
 
 	static void seed(int val) {
 		gen = std::mt19937(val);
 	}
 
 	static int rand() {
+		if (stream) return abs((int)(*stream)());
 		return abs((int)gen());
 	}
 
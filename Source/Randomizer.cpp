@@ -24,23 +24,21 @@ std::vector<int> copyWithoutElements(const std::vector<int>& input, const std::v
 	return result;
 }
 
-void Randomizer::GenerateNormal(HWND loadingHandle) {
+void Randomizer::GenerateNormal() {
 	std::shared_ptr<PuzzleList> puzzles = std::make_shared<PuzzleList>();
-	puzzles->setLoadingHandle(loadingHandle);
 	puzzles->setSeed(seed, seedIsRNG, colorblind);
 	puzzles->GenerateAllN();
 	if (doubleMode) ShufflePanels(false);
 }
 
-void Randomizer::GenerateHard(HWND loadingHandle) {
+void Randomizer::GenerateHard() {
 	std::shared_ptr<PuzzleList> puzzles = std::make_shared<PuzzleList>();
-	puzzles->setLoadingHandle(loadingHandle);
 	puzzles->setSeed(seed, seedIsRNG, colorblind);
 	puzzles->GenerateAllH();
 	if (doubleMode) ShufflePanels(true);
-	SetWindowText(loadingHandle, L"Starting watchdogs...");
+	ProgressChannel::get()->publish(L"Starting watchdogs...");
 	Panel::StartArrowWatchdogs(_shuffleMapping);
-	SetWindowText(loadingHandle, L"Done!");
+	ProgressChannel::get()->publish(L"Done!");
 }
 
 template <class T>
@@ -183,6 +181,7 @@ void Randomizer::RandomizeAudiologs()
 }
 
 void Randomizer::SwapPanels(int panel1, int panel2, int flags) {
+	TraceScope trace("Randomizer::SwapPanels");
 	if (!_shuffleMapping.count(panel1)) {
 		_shuffleMapping[panel1] = panel1;
 	}
@@ -253,11 +252,17 @@ void Randomizer::SwapPanels(int panel1, int panel2, int flags) {
 		offsets[SPECULAR_TEXTURE] = sizeof(void*);
 	}
 
+	//Fields that follow each other directly are written together
+	std::vector<std::pair<int, int>> runs;
 	for (auto const&[offset, size] : offsets) {
-		std::vector<byte> panel1data = _memory->ReadPanelData<byte>(panel1, offset, size);
-		std::vector<byte> panel2data = _memory->ReadPanelData<byte>(panel2, offset, size);
-		_memory->WritePanelData<byte>(panel2, offset, panel1data);
-		_memory->WritePanelData<byte>(panel1, offset, panel2data);
+		if (runs.size() > 0 && runs.back().first + runs.back().second == offset) runs.back().second += size;
+		else runs.push_back({ offset, size });
+	}
+	PanelSnapshot snapshot1 = _memory->ReadPanelSnapshot(panel1);
+	PanelSnapshot snapshot2 = _memory->ReadPanelSnapshot(panel2);
+	for (auto const&[offset, size] : runs) {
+		_memory->WritePanelData<byte>(panel2, offset, snapshot1.get<byte>(offset, size));
+		_memory->WritePanelData<byte>(panel1, offset, snapshot2.get<byte>(offset, size));
 	}
 	_memory->WritePanelData<int>(panel1, NEEDS_REDRAW, { 1 });
 	_memory->WritePanelData<int>(panel2, NEEDS_REDRAW, { 1 });
@@ -8,8 +8,8 @@ class Randomizer {
 public:
 	void RestoreLineWidths();
 
-	void GenerateNormal(HWND loadingHandle);
-	void GenerateHard(HWND loadingHandle);
+	void GenerateNormal();
+	void GenerateHard();
 
 	void AdjustSpeed();
 
@@ -44,7 +44,7 @@ private:
 	void ShuffleRange(std::vector<int>& order, size_t startIndex, size_t endIndex);
 	void ShufflePanels(bool hard);
 
-	std::shared_ptr<Memory> _memory = std::make_shared<Memory>("witness64_d3d11.exe");
+	std::shared_ptr<Memory> _memory = Memory::get();
 	std::set<int> _alreadySwapped;
 	std::map<int, int> _shuffleMapping;
 
@@ -0,0 +1,88 @@
+// This is an open source non-commercial project. Dear PVS-Studio, please check it.
+
+// PVS-Studio Static Code Analyzer for C, C++, C#, and Java: http://www.viva64.com
+
+#include "RemoteArena.h"
+
+int RemoteArena::sizeClass(size_t size) {
+	int sizeClass = 0;
+	for (size_t slot = ARENA_MIN_SLOT; slot < size; slot *= 2) sizeClass++;
+	return sizeClass;
+}
+
+uintptr_t RemoteArena::alloc(MemoryBackend& backend, size_t size) {
+	if (size == 0) size = 1;
+	uintptr_t address = 0;
+	size_t slot;
+
+	if (size > ARENA_MAX_SLOT) {
+		slot = size;
+		auto search = _freeLarge.lower_bound(size);
+		if (search != _freeLarge.end()) {
+			slot = search->first;
+			address = search->second;
+			_freeLarge.erase(search);
+			_stats.reused++;
+		}
+		else {
+			address = reinterpret_cast<uintptr_t>(backend.alloc(size, false));
+			if (address == 0) return 0;
+			_stats.blocks++;
+			_stats.bytesReserved += size;
+		}
+	}
+	else {
+		int index = sizeClass(size);
+		slot = static_cast<size_t>(ARENA_MIN_SLOT) << index;
+		if (!_free[index].empty()) {
+			address = _free[index].back();
+			_free[index].pop_back();
+			_stats.reused++;
+		}
+		else {
+			if (_end - _next < slot) {
+				// What is left of the current block is abandoned. It is at most one slot's worth.
+				_next = reinterpret_cast<uintptr_t>(backend.alloc(ARENA_BLOCK_SIZE, false));
+				if (_next == 0) {
+					_end = 0;
+					return 0;
+				}
+				_end = _next + ARENA_BLOCK_SIZE;
+				_stats.blocks++;
+				_stats.bytesReserved += ARENA_BLOCK_SIZE;
+			}
+			address = _next;
+			_next += slot;
+		}
+	}
+
+	_live[address] = slot;
+	_stats.allocations++;
+	_stats.bytesInUse += slot;
+	return address;
+}
+
+void RemoteArena::free(uintptr_t address) {
+	auto search = _live.find(address);
+	if (search == _live.end()) return;
+	size_t slot = search->second;
+	_live.erase(search);
+	if (slot > ARENA_MAX_SLOT) _freeLarge.insert({ slot, address });
+	else _free[sizeClass(slot)].push_back(address);
+	_stats.frees++;
+	_stats.bytesInUse -= slot;
+}
+
+size_t RemoteArena::capacity(uintptr_t address) const {
+	auto search = _live.find(address);
+	return search == _live.end() ? 0 : search->second;
+}
+
+void RemoteArena::reset() {
+	for (std::vector<uintptr_t>& slots : _free) slots.clear();
+	_freeLarge.clear();
+	_live.clear();
+	_next = 0;
+	_end = 0;
+	_stats = RemoteArenaStats();
+}
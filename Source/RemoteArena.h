@@ -0,0 +1,43 @@
+#pragma once
+#include "MemoryBackend.h"
+
+#define ARENA_BLOCK_SIZE  0x100000 // Memory reserved in the game at once. Slots are carved out of it.
+#define ARENA_MIN_SLOT        0x10 // Smallest size class. Every class is twice the one before.
+#define ARENA_MAX_SLOT     0x10000 // Largest size class. Bigger requests get an allocation of their own.
+
+struct RemoteArenaStats {
+	size_t blocks = 0; // Allocations made in the game, including the ones for large requests
+	size_t bytesReserved = 0;
+	size_t bytesInUse = 0; // Sum of the slot sizes handed out and not freed
+	size_t allocations = 0;
+	size_t reused = 0; // Allocations served from a freed slot
+	size_t frees = 0;
+};
+
+// Hands out memory in the game process for arrays that outgrow the game's own. Small requests are rounded up to a power of two and carved
+//   out of large blocks; freed slots are kept per size class and handed out again, so resizing an array over and over doesn't leak or pay
+//   for an allocation in the game every time. Nothing is ever given back to the game, since it may still hold pointers into a block.
+class RemoteArena
+{
+public:
+	// Returns 0 if the game wouldn't give us memory.
+	uintptr_t alloc(MemoryBackend& backend, size_t size);
+	// Make a slot from alloc available again. The caller has to make sure the game no longer uses it.
+	void free(uintptr_t address);
+	// Usable size of a slot from alloc.
+	size_t capacity(uintptr_t address) const;
+
+	const RemoteArenaStats& stats() const { return _stats; }
+	// Forget everything, for when the process the memory belonged to is gone.
+	void reset();
+
+private:
+	static int sizeClass(size_t size);
+
+	std::vector<std::vector<uintptr_t>> _free = std::vector<std::vector<uintptr_t>>(sizeClass(ARENA_MAX_SLOT) + 1);
+	std::multimap<size_t, uintptr_t> _freeLarge; // By size
+	std::map<uintptr_t, size_t> _live; // Slot size of everything handed out
+	uintptr_t _next = 0; // Next unused byte of the current block
+	uintptr_t _end = 0;
+	RemoteArenaStats _stats;
+};
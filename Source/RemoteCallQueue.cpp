@@ -0,0 +1,80 @@
+// This is an open source non-commercial project. Dear PVS-Studio, please check it.
+
+// PVS-Studio Static Code Analyzer for C, C++, C#, and Java: http://www.viva64.com
+
+#include "RemoteCallQueue.h"
+#include <algorithm>
+#include <cstring>
+
+#define REMOTE_CALL_BLOCK_SIZE (REMOTE_CALL_QUEUE_OFFSET + sizeof(uint64_t) + REMOTE_CALL_CAPACITY * sizeof(RemoteCall))
+
+std::vector<uint8_t> RemoteCallQueue::stub() {
+	std::vector<uint8_t> code = {
+		0x53,                         // push rbx
+		0x56,                         // push rsi
+		0x48, 0x83, 0xEC, 0x28,       // sub rsp, 28 (shadow space, and keeps the stack 16 byte aligned for the calls)
+		0x48, 0x8D, 0x1D, 0x00, 0x00, 0x00, 0x00, // lea rbx, [queue]
+		0x8B, 0x33,                   // mov esi, [rbx] (count)
+		0x48, 0x83, 0xC3, 0x08,       // add rbx, 8 (first record)
+		// next:
+		0x85, 0xF6,                   // test esi, esi
+		0x74, 0x1A,                   // je done
+		0x48, 0x8B, 0x4B, 0x08,       // mov rcx, [rbx+8]
+		0x48, 0x8B, 0x53, 0x10,       // mov rdx, [rbx+10]
+		0x4C, 0x8B, 0x43, 0x18,       // mov r8, [rbx+18]
+		0x4C, 0x8B, 0x4B, 0x20,       // mov r9, [rbx+20]
+		0xFF, 0x13,                   // call [rbx]
+		0x48, 0x83, 0xC3, 0x28,       // add rbx, 28 (next record)
+		0xFF, 0xCE,                   // dec esi
+		0xEB, 0xE2,                   // jmp next
+		// done:
+		0x48, 0x83, 0xC4, 0x28,       // add rsp, 28
+		0x5E,                         // pop rsi
+		0x5B,                         // pop rbx
+		0x31, 0xC0,                   // xor eax, eax
+		0xC3,                         // ret
+	};
+	static_assert(sizeof(RemoteCall) == 0x28, "The stub steps through the queue 0x28 bytes at a time");
+
+	// The lea is relative to the end of its own instruction, which is 13 bytes in
+	int32_t queueOffset = REMOTE_CALL_QUEUE_OFFSET - 13;
+	std::memcpy(&code[9], &queueOffset, sizeof(queueOffset));
+	code.resize(REMOTE_CALL_QUEUE_OFFSET, 0xCC);
+	return code;
+}
+
+std::vector<uint8_t> RemoteCallQueue::encode(const std::vector<RemoteCall>& calls) {
+	uint64_t count = calls.size();
+	std::vector<uint8_t> queue(sizeof(count) + calls.size() * sizeof(RemoteCall));
+	std::memcpy(&queue[0], &count, sizeof(count));
+	if (!calls.empty()) std::memcpy(&queue[sizeof(count)], &calls[0], calls.size() * sizeof(RemoteCall));
+	return queue;
+}
+
+bool RemoteCallQueue::flush(MemoryBackend& backend) {
+	if (_pending.empty()) return true;
+	if (_block == 0) {
+		_block = reinterpret_cast<uintptr_t>(backend.alloc(REMOTE_CALL_BLOCK_SIZE, true));
+		std::vector<uint8_t> code = stub();
+		if (_block != 0 && !backend.write(_block, &code[0], code.size())) _block = 0;
+		if (_block == 0) {
+			_pending.clear();
+			return false;
+		}
+	}
+
+	bool ok = true;
+	for (size_t start = 0; start < _pending.size(); start += REMOTE_CALL_CAPACITY) {
+		size_t end = std::min(_pending.size(), start + REMOTE_CALL_CAPACITY);
+		std::vector<uint8_t> queue = encode(std::vector<RemoteCall>(_pending.begin() + start, _pending.begin() + end));
+		// The stub has finished with the previous batch by now, since every run is waited on.
+		ok = backend.write(_block + REMOTE_CALL_QUEUE_OFFSET, &queue[0], queue.size()) && backend.execute(reinterpret_cast<void*>(_block), true) && ok;
+	}
+	_pending.clear();
+	return ok;
+}
+
+void RemoteCallQueue::reset() {
+	_pending.clear();
+	_block = 0;
+}
@@ -0,0 +1,37 @@
+#pragma once
+#include "MemoryBackend.h"
+
+#define REMOTE_CALL_ARGS          4 // Arguments per call: rcx, rdx, r8 and r9. Everything the game's functions we call need.
+#define REMOTE_CALL_CAPACITY    256 // Calls run per remote thread. Longer batches are run in several goes.
+#define REMOTE_CALL_QUEUE_OFFSET 64 // Where the queue starts in the resident block, after the stub.
+
+// One call for the stub to make: function(args[0], args[1], args[2], args[3]), using the x64 Windows calling convention.
+struct RemoteCall {
+	uint64_t function;
+	uint64_t args[REMOTE_CALL_ARGS];
+};
+
+// Makes calls into the game through a block of code that stays resident in it. The block holds a small stub, followed by the queue: a 64 bit
+//   count, then that many RemoteCall records. Starting a thread on the stub makes every queued call in order, so a batch of calls costs one
+//   remote thread instead of an allocation and a thread for each.
+// The stub only uses the queue right after itself, so it can be tested in-process by copying stub() and encode() into executable memory
+//   and calling it as an ms_abi function of one (unused) pointer argument.
+class RemoteCallQueue
+{
+public:
+	static std::vector<uint8_t> stub();
+	// The queue as the stub expects it.
+	static std::vector<uint8_t> encode(const std::vector<RemoteCall>& calls);
+
+	void queue(const RemoteCall& call) { _pending.push_back(call); }
+	size_t pending() const { return _pending.size(); }
+	// Run every queued call in the game, and wait for them to finish. The resident block is allocated on first use.
+	// Returns false if it couldn't be, in which case the queued calls are dropped.
+	bool flush(MemoryBackend& backend);
+	// Forget the resident block, for when the process it was allocated in is gone.
+	void reset();
+
+private:
+	std::vector<RemoteCall> _pending;
+	uintptr_t _block = 0;
+};
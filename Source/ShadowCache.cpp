@@ -0,0 +1,95 @@
+// This is an open source non-commercial project. Dear PVS-Studio, please check it.
+
+// PVS-Studio Static Code Analyzer for C, C++, C#, and Java: http://www.viva64.com
+
+#include "ShadowCache.h"
+#include <cstring>
+
+static bool inPanel(int offset, size_t size) {
+	return offset >= 0 && size <= SHADOW_PANEL_SIZE && static_cast<size_t>(offset) <= SHADOW_PANEL_SIZE - size;
+}
+
+void ShadowCache::setVolatile(int offset, size_t size) {
+	if (!inPanel(offset, size)) return;
+	for (size_t i = 0; i < size; i++) _volatile[offset + i] = true;
+}
+
+bool ShadowCache::count(bool hit, size_t size) {
+	if (hit) {
+		_stats.hits++;
+		_stats.bytesSkipped += size;
+	}
+	else {
+		_stats.misses++;
+	}
+	return hit;
+}
+
+bool ShadowCache::matches(int panel, int offset, const void* data, size_t size) {
+	if (!inPanel(offset, size)) return count(false, size);
+	auto search = _panels.find(panel);
+	if (search == _panels.end()) return count(false, size);
+	const Panel& shadow = search->second;
+	for (size_t i = offset; i < offset + size; i++) {
+		if (_volatile[i] || !shadow.known[i]) return count(false, size);
+	}
+	return count(std::memcmp(&shadow.data[offset], data, size) == 0, size);
+}
+
+void ShadowCache::store(int panel, int offset, const void* data, size_t size) {
+	if (!inPanel(offset, size)) return;
+	Panel& shadow = _panels[panel];
+	bool changed = std::memcmp(&shadow.data[offset], data, size) != 0;
+	for (size_t i = offset; i < offset + size; i++) {
+		changed = changed || !shadow.known[i];
+		shadow.known[i] = true;
+	}
+	std::memcpy(&shadow.data[offset], data, size);
+	if (!changed) return;
+
+	// Any array pointer in the range may now point somewhere else
+	auto first = _arrays.lower_bound({ panel, offset - static_cast<int>(sizeof(uintptr_t)) + 1 });
+	auto last = _arrays.lower_bound({ panel, offset + static_cast<int>(size) });
+	_arrays.erase(first, last);
+}
+
+bool ShadowCache::matchesArray(int panel, int offset, const void* data, size_t size) {
+	if (inPanel(offset, sizeof(uintptr_t)) && _volatile[offset]) return count(false, size);
+	auto search = _arrays.find({ panel, offset });
+	if (search == _arrays.end() || search->second.size() < size) return count(false, size);
+	return count(std::memcmp(&search->second[0], data, size) == 0, size);
+}
+
+void ShadowCache::storeArray(int panel, int offset, const void* data, size_t size) {
+	if (size == 0) return;
+	std::vector<uint8_t>& shadow = _arrays[{ panel, offset }];
+	const uint8_t* bytes = static_cast<const uint8_t*>(data);
+	// A shorter read or write leaves what we know about the rest of the array alone
+	if (shadow.size() < size) shadow.resize(size);
+	std::memcpy(&shadow[0], bytes, size);
+}
+
+void ShadowCache::forget(int panel, int offset, size_t size) {
+	if (!inPanel(offset, size)) return;
+	auto search = _panels.find(panel);
+	if (search == _panels.end()) return;
+	for (size_t i = offset; i < offset + size; i++) search->second.known[i] = false;
+	// Arrays the forgotten bytes pointed to are forgotten with them
+	auto first = _arrays.lower_bound({ panel, offset - static_cast<int>(sizeof(uintptr_t)) + 1 });
+	auto last = _arrays.lower_bound({ panel, offset + static_cast<int>(size) });
+	_arrays.erase(first, last);
+}
+
+void ShadowCache::forgetArray(int panel, int offset) {
+	_arrays.erase({ panel, offset });
+}
+
+void ShadowCache::invalidate(int panel) {
+	_panels.erase(panel);
+	_arrays.erase(_arrays.lower_bound({ panel, INT32_MIN }), _arrays.lower_bound({ panel + 1, INT32_MIN }));
+}
+
+void ShadowCache::clear() {
+	_panels.clear();
+	_arrays.clear();
+}
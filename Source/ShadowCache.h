@@ -0,0 +1,55 @@
+#pragma once
+#include <bitset>
+#include <cstdint>
+#include <map>
+#include <vector>
+
+#define SHADOW_PANEL_SIZE 0x600 // Bytes of each panel's entity that are shadowed. Covers every panel offset in Randomizer.h.
+
+struct ShadowCacheStats {
+	size_t hits = 0; // Writes skipped because the game already held the same bytes
+	size_t misses = 0; // Writes that had to be made
+	size_t bytesSkipped = 0;
+};
+
+// The last bytes we read from or wrote to each panel's fields, and to the arrays they point to. A write that wouldn't change anything can
+//   then be skipped. Only bytes we've seen are known; anything else, and every field marked volatile, is always written.
+// Fields the game changes on its own must be marked volatile, since the shadow can't see those changes until they're read again.
+class ShadowCache
+{
+public:
+	// Never skip writes to these bytes of a panel.
+	void setVolatile(int offset, size_t size);
+
+	// True if writing data to the panel field wouldn't change it. Counts a hit or a miss.
+	bool matches(int panel, int offset, const void* data, size_t size);
+	// Remember bytes just read from or written to a panel field.
+	void store(int panel, int offset, const void* data, size_t size);
+
+	// The same for the array the pointer at a panel offset points to. data is the start of the array.
+	bool matchesArray(int panel, int offset, const void* data, size_t size);
+	void storeArray(int panel, int offset, const void* data, size_t size);
+
+	// Forget some bytes of a panel field, or an array, for when it isn't known what the game holds there.
+	void forget(int panel, int offset, size_t size);
+	void forgetArray(int panel, int offset);
+	// Forget what is known about a panel, for when the game replaces its entity.
+	void invalidate(int panel);
+	// Forget everything, for when the game reloads or the process is gone.
+	void clear();
+
+	const ShadowCacheStats& stats() const { return _stats; }
+
+private:
+	struct Panel {
+		uint8_t data[SHADOW_PANEL_SIZE] = {};
+		std::bitset<SHADOW_PANEL_SIZE> known;
+	};
+
+	bool count(bool hit, size_t size);
+
+	std::map<int, Panel> _panels;
+	std::map<std::pair<int, int>, std::vector<uint8_t>> _arrays;
+	std::bitset<SHADOW_PANEL_SIZE> _volatile;
+	ShadowCacheStats _stats;
+};
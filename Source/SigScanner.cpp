@@ -0,0 +1,134 @@
+// This is an open source non-commercial project. Dear PVS-Studio, please check it.
+
+// PVS-Studio Static Code Analyzer for C, C++, C#, and Java: http://www.viva64.com
+
+#include "SigScanner.h"
+#include "Utilities.h"
+#include <algorithm>
+#include <queue>
+#include <stdexcept>
+
+int SigScanner::add(const std::vector<uint8_t>& bytes, const Callback& callback) {
+	return add(bytes, std::string(bytes.size(), 'x'), callback);
+}
+
+int SigScanner::add(const std::vector<uint8_t>& bytes, const std::string& mask, const Callback& callback) {
+	if (mask.size() != bytes.size()) throw std::invalid_argument("Signature mask doesn't match its length");
+
+	Signature signature;
+	signature.bytes = bytes;
+	signature.mask = mask;
+	signature.callback = callback;
+	signature.anchor = 0;
+	signature.anchorLength = 0;
+	for (int i = 0, run = 0; i < bytes.size(); i++) {
+		run = mask[i] != '?' ? run + 1 : 0;
+		if (run > signature.anchorLength) {
+			signature.anchor = i + 1 - run;
+			signature.anchorLength = run;
+		}
+	}
+	if (signature.anchorLength == 0) throw std::invalid_argument("Signature needs at least one exact byte");
+
+	_signatures.push_back(signature);
+	_remaining++;
+	_compiled = false;
+	return static_cast<int>(_signatures.size()) - 1;
+}
+
+void SigScanner::compile() {
+	_next.assign(1, {});
+	_next[0].fill(-1);
+	_matches.assign(1, {});
+
+	// Build the trie of anchors
+	for (int id = 0; id < _signatures.size(); id++) {
+		const Signature& signature = _signatures[id];
+		int state = 0;
+		for (int i = signature.anchor; i < signature.anchor + signature.anchorLength; i++) {
+			uint8_t b = signature.bytes[i];
+			if (_next[state][b] == -1) {
+				_next[state][b] = static_cast<int>(_next.size());
+				_next.emplace_back();
+				_next.back().fill(-1);
+				_matches.emplace_back();
+			}
+			state = _next[state][b];
+		}
+		_matches[state].push_back(id);
+	}
+
+	// Turn it into a DFA. States are visited breadth first, so a state's failure state is always finished before the state itself.
+	std::vector<int> fail(_next.size(), 0);
+	std::queue<int> pending;
+	for (int b = 0; b < 256; b++) {
+		if (_next[0][b] == -1) _next[0][b] = 0;
+		else pending.push(_next[0][b]);
+	}
+	while (!pending.empty()) {
+		int state = pending.front();
+		pending.pop();
+		_matches[state].insert(_matches[state].end(), _matches[fail[state]].begin(), _matches[fail[state]].end());
+		for (int b = 0; b < 256; b++) {
+			int next = _next[state][b];
+			if (next == -1) {
+				_next[state][b] = _next[fail[state]][b];
+			}
+			else {
+				fail[next] = _next[fail[state]][b];
+				pending.push(next);
+			}
+		}
+	}
+	_compiled = true;
+}
+
+bool SigScanner::verify(const Signature& signature, const std::vector<uint8_t>& data, size_t start) {
+	if (start + signature.bytes.size() > data.size()) return false;
+	for (size_t i = 0; i < signature.bytes.size(); i++) {
+		if (signature.mask[i] != '?' && data[start + i] != signature.bytes[i]) return false;
+	}
+	return true;
+}
+
+// Hand a verified match to the signature's callback, and stop looking for the signature if it is accepted.
+void SigScanner::accept(Signature& signature, uint64_t offset, size_t start, const std::vector<uint8_t>& data) {
+	if (signature.callback(offset, static_cast<int>(start), data)) {
+		signature.result = offset + start;
+		_remaining--;
+	}
+}
+
+bool SigScanner::scan(uint64_t offset, const std::vector<uint8_t>& data, size_t limit) {
+	// A lone signature is found faster by the vectorized search than by walking the automaton.
+	if (_signatures.size() == 1) {
+		Signature& signature = _signatures[0];
+		int end = static_cast<int>(std::min(limit, data.size()));
+		for (int index = 0; signature.result == UINT64_MAX; index++) {
+			index = Utilities::findSequence(data, signature.bytes, signature.mask, index, end);
+			if (index == -1) break;
+			accept(signature, offset, index, data);
+		}
+		return _remaining == 0;
+	}
+
+	if (!_compiled) compile();
+
+	int state = 0;
+	for (size_t i = 0; i < data.size() && _remaining > 0; i++) {
+		state = _next[state][data[i]];
+		for (int id : _matches[state]) {
+			Signature& signature = _signatures[id];
+			if (signature.result != UINT64_MAX) continue;
+
+			// i is the last byte of the anchor, which is anchor bytes into the signature
+			size_t anchorStart = i + 1 - signature.anchorLength;
+			if (anchorStart < signature.anchor) continue;
+			size_t start = anchorStart - signature.anchor;
+			if (start >= limit || !verify(signature, data, start)) continue;
+
+			accept(signature, offset, start, data);
+		}
+	}
+	return _remaining == 0;
+}
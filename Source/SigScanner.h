@@ -0,0 +1,51 @@
+#pragma once
+#include <array>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+
+// Finds any number of signatures in one pass over a block of memory. Each signature's longest run of exact bytes is compiled into a single
+//   Aho-Corasick automaton, so every byte of the block is looked at once no matter how many signatures there are. Matches of that run are
+//   then checked against the whole signature, wildcards included, and handed to the signature's callback.
+class SigScanner
+{
+public:
+	// Called with the address the block was read from (relative to the start of the scan), the index of the match in the block and the block
+	//   itself. Returning false discards the match and keeps looking for that signature.
+	using Callback = std::function<bool(uint64_t offset, int index, const std::vector<uint8_t>& data)>;
+
+	// Register a signature, returning its id. In mask, 'x' means the byte has to match and '?' means any byte is accepted.
+	int add(const std::vector<uint8_t>& bytes, const Callback& callback);
+	int add(const std::vector<uint8_t>& bytes, const std::string& mask, const Callback& callback);
+
+	// Look for every signature that hasn't been accepted yet in data, which was read from offset. Only matches starting before limit are
+	//   reported, so blocks can overlap by the length of the longest signature without reporting a match twice.
+	// Returns true once every signature has been accepted.
+	bool scan(uint64_t offset, const std::vector<uint8_t>& data, size_t limit);
+
+	// Where the accepted match of a signature starts (offset + index), or UINT64_MAX if it wasn't found.
+	uint64_t result(int id) const { return _signatures[id].result; }
+	bool done() const { return _remaining == 0; }
+	size_t size() const { return _signatures.size(); }
+
+private:
+	struct Signature {
+		std::vector<uint8_t> bytes;
+		std::string mask;
+		Callback callback;
+		int anchor; // Start of the longest run of exact bytes, which is what the automaton looks for
+		int anchorLength;
+		uint64_t result = UINT64_MAX;
+	};
+
+	void compile();
+	bool verify(const Signature& signature, const std::vector<uint8_t>& data, size_t start);
+	void accept(Signature& signature, uint64_t offset, size_t start, const std::vector<uint8_t>& data);
+
+	std::vector<Signature> _signatures;
+	std::vector<std::array<int, 256>> _next; // State transitions, with the failure links already folded in
+	std::vector<std::vector<int>> _matches; // Signatures whose anchor ends in each state
+	bool _compiled = false;
+	size_t _remaining = 0;
+};
@@ -4,6 +4,7 @@
 
 #include "Special.h"
 #include "MultiGenerate.h"
+#include "PivotGenerate.h"
 #include "Archipelago/SkipSpecialCases.h"
 #include "Quaternion.h"
 #include "../App/Version.h"
@@ -805,6 +806,7 @@ bool Special::generate2Bridge(int id1, int id2, std::vector<std::shared_ptr<Gene
 		gens[i]->setPath(std::set<Point>());
 		std::vector<Point> walls = { { 12, 1 },{ 12, 3 },{ 3, 8 },{ 9, 8 } };
 		for (Point p : walls) gens[i]->setSymbol(Decoration::Gap, p.first, p.second);
+		gens[i]->blockPos = { { 11, 1 },{ 11, 3 } }; //These have to stay empty on both panels, so they are left out of the symbol placement instead of being checked afterwards
 		if (i % 2 == 0) {
 			gens[i]->setObstructions({ { 5, 8 },{ 6, 7 },{ 7, 8 } });
 		}
@@ -1024,6 +1026,51 @@ bool checkShape(const std::set<Point>& shape, int direction) {
 	return false;
 }
 
+//Convert a shape symbol into the grid blocks of its shape, as they would appear in the bottom left corner of a pillar panel
+Shape symbolToShape(int symbol) {
+	Shape shape;
+	for (int j = 0; j < 16; j++) {
+		if (symbol & (1 << (j + 16))) {
+			shape.emplace(Point((j % 4) * 2 + 1, 8 - ((j / 4) * 2 + 1)));
+		}
+	}
+	return shape;
+}
+
+Shape translateShape(const Shape& shape, int offset) {
+	Point shift = Point((offset % 4) * 2, -(offset / 4) * 2);
+	Shape newShape;
+	for (Point p : shape) newShape.insert(p + shift);
+	return newShape;
+}
+
+//Pick an offset for the floor shape on each pillar panel so that every one of them can be drawn, and pick which panel gets the rotated shape.
+//rotated - the rotated symbol for each shape, or 0 if it can't be rotated. Leave it empty if no panel is rotated. rotateIndex is -1 if none is.
+//Every offset is tried instead of sampling until one fits, so a floor that can't be laid out is found straight away.
+//Moves the shapes into place and returns true if a layout was found.
+bool placeFloorShapes(std::vector<Shape>& shapes, const std::vector<int>& rotated, int& rotateIndex) {
+	std::vector<int> offsets(shapes.size());
+	for (int i = 0; i < shapes.size(); i++) {
+		std::vector<int> fits;
+		for (int offset = 0; offset < 16; offset++) {
+			if (checkShape(translateShape(shapes[i], offset), i % 2)) fits.push_back(offset);
+		}
+		if (fits.size() == 0)
+			return false;
+		offsets[i] = fits[Random::rand() % fits.size()];
+	}
+	for (int i = 0; i < shapes.size(); i++) shapes[i] = translateShape(shapes[i], offsets[i]);
+	rotateIndex = -1;
+	if (rotated.size() > 0) {
+		//One of the first three panels gets the rotated shape. If none of them can be rotated, the last panel gets it instead, if it can be.
+		std::vector<int> candidates;
+		for (int i = 0; i < 3; i++) if (rotated[i]) candidates.push_back(i);
+		if (candidates.size() > 0) rotateIndex = candidates[Random::rand() % candidates.size()];
+		else if (rotated[3]) rotateIndex = 3;
+	}
+	return true;
+}
+
 void Special::generateMountainFloor()
 {
 	std::vector<int> ids = { 0x09EFF, 0x09F01, 0x09FC1, 0x09F8E };
@@ -1033,41 +1080,32 @@ void Special::generateMountainFloor()
 	std::vector<Point> floorPos = { { 3, 3 },{ 7, 3 },{ 3, 7 },{ 7, 7 } };
 	generator->openPos = std::set<Point>(floorPos.begin(), floorPos.end());
 	generator->setFlag(Generate::Config::DisableWrite);
-	//Make sure no duplicated symbols
-	std::set<int> sym;
+	std::vector<Shape> shapes;
+	std::vector<int> rotated;
+	int rotateIndex;
 	do {
-		generator->generate(idfloor, Decoration::Poly, 4);
-		sym.clear();
-		for (Point p : floorPos) sym.insert(generator->get(p));
-	} while (sym.size() < 4);
+		//Make sure no duplicated symbols
+		std::set<int> sym;
+		do {
+			generator->generate(idfloor, Decoration::Poly, 4);
+			sym.clear();
+			for (Point p : floorPos) sym.insert(generator->get(p));
+		} while (sym.size() < 4);
+		shapes.clear();
+		rotated.clear();
+		for (Point p : floorPos) {
+			shapes.push_back(symbolToShape(generator->get(p)));
+			rotated.push_back(generator->make_shape_symbol(shapes.back(), true, false));
+		}
+	} while (!placeFloorShapes(shapes, rotated, rotateIndex));
 
-	int rotateIndex = Random::rand() % 3;
 	for (int i = 0; i < 4; i++) {
 		int symbol = generator->get(floorPos[i]);
 
 		correctShapesById[ids[i]] = symbol;
 
-		//Convert to shape
-		Shape shape;
-		for (int j = 0; j < 16; j++) {
-			if (symbol & (1 << (j + 16))) {
-				shape.emplace(Point((j % 4) * 2 + 1, 8 - ((j / 4) * 2 + 1)));
-			}
-		}
-		//Translate randomly
-		Shape newShape;
-		do {
-			Point shift = Point((Random::rand() % 4) * 2, -(Random::rand() % 4) * 2);
-			newShape.clear();
-			for (Point p : shape) newShape.insert(p + shift);
-		} while (!checkShape(newShape, i % 2));
-		if (i == rotateIndex) {
-			symbol = generator->make_shape_symbol(newShape, true, false);
-			if (symbol == 0) {
-				symbol = generator->get(floorPos[i]);
-				rotateIndex++;
-			}
-		}
+		if (i == rotateIndex) symbol = rotated[i];
+		Shape newShape = shapes[i];
 
 		Generate gen;
 		for (Point p : newShape) {
@@ -1119,38 +1157,31 @@ void Special::generateMountainFloorH()
 	generator->setSymmetry(Panel::Symmetry::Rotational);
 	generator->setSymbol(Decoration::Start, 0, 10); generator->setSymbol(Decoration::Start, 10, 0);
 	generator->setSymbol(Decoration::Exit, 0, 0); generator->setSymbol(Decoration::Exit, 10, 10);
-	//Make sure no duplicated symbols
-	std::set<int> sym;
+	std::vector<Shape> shapes;
+	int rotateIndex;
 	do {
-		generator->generate(idfloor, Decoration::Poly, 6);
-		sym.clear();
-		for (Point p : floorPos) sym.insert(generator->get(p));
-	} while (sym.size() < 4);
+		//Make sure no duplicated symbols, and that exactly two of the shapes are big enough to get combined symbols on their pillar
+		std::set<int> sym;
+		int big;
+		do {
+			generator->generate(idfloor, Decoration::Poly, 6);
+			sym.clear();
+			big = 0;
+			for (Point p : floorPos) {
+				sym.insert(generator->get(p));
+				if (symbolToShape(generator->get(p)).size() > 5) big++;
+			}
+		} while (sym.size() < 4 || big != 2);
+		shapes.clear();
+		for (Point p : floorPos) shapes.push_back(symbolToShape(generator->get(p)));
+	} while (!placeFloorShapes(shapes, { }, rotateIndex));
 
 	int combine = 0;
 	for (int i = 0; i < 4; i++) {
 		int symbol = generator->get(floorPos[i]);
 
 		correctShapesById[ids[i]] = symbol;
-		//Convert to shape
-		Shape shape;
-		for (int j = 0; j < 16; j++) {
-			if (symbol & (1 << (j + 16))) {
-				shape.emplace(Point((j % 4) * 2 + 1, 8 - ((j / 4) * 2 + 1)));
-			}
-		}
-		//Translate randomly
-		Shape newShape;
-		int fails = 0;
-		do {
-			if (fails++ == 50) {
-				generateMountainFloorH();
-				return;
-			}
-			Point shift = Point((Random::rand() % 4) * 2, -(Random::rand() % 4) * 2);
-			newShape.clear();
-			for (Point p : shape) newShape.insert(p + shift);
-		} while (!checkShape(newShape, i % 2));
+		Shape newShape = shapes[i];
 
 		Generate gen;
 		for (Point p : newShape) {
@@ -1171,7 +1202,7 @@ void Special::generateMountainFloorH()
 			if (combine == 1) symbols = PuzzleSymbols({ { Decoration::Poly, 3 },{ Decoration::Poly | Decoration::Negative | Decoration::Color::Cyan, 1 } });
 			combine++;
 		}
-		fails = 0;
+		int fails = 0;
 		while (!gen.generate(ids[i], symbols)) {
 			if (fails++ > 50) {
 				generateMountainFloorH();
@@ -1212,6 +1243,30 @@ void Special::generateMountainFloorH()
 
 void Special::generatePivotPanel(int id, Point gridSize, const std::vector<std::pair<int, int>>& symbolVec, bool colorblind) {
 	int width = gridSize.first * 2 + 1, height = gridSize.second * 2 + 1;
+	PivotGenerate pivot(width, height, { width / 2, height - 1 }, { { 0, height / 2 }, { width - 1, height / 2 }, { width / 2, 0 } });
+	if (pivot.generate(symbolVec, 2000)) {
+		std::shared_ptr<Generate> gen = std::make_shared<Generate>();
+		gen->colorblind = colorblind;
+		gen->setGridSize(gridSize.first, gridSize.second);
+		gen->setSymbol(Decoration::Start, width / 2, height - 1);
+		gen->setSymbol(Decoration::Exit, 0, height / 2);
+		gen->setSymbol(Decoration::Exit, width - 1, height / 2);
+		gen->setSymbol(Decoration::Exit, width / 2, 0);
+		for (int x = 1; x < width; x += 2) {
+			for (int y = 1; y < height; y += 2) {
+				if (pivot.grid[x][y]) gen->setSymbol(static_cast<Decoration::Shape>(pivot.grid[x][y]), x, y);
+			}
+		}
+		gen->setFlag(Generate::Config::FixBackground);
+		gen->setFlag(Generate::Config::TreehouseColors);
+		gen->initPanel(id);
+		gen->write(id);
+		generator->incrementProgress();
+		int style = ReadPanelData<int>(id, STYLE_FLAGS);
+		WritePanelData(id, STYLE_FLAGS, { style | Panel::Style::IS_PIVOTABLE });
+		return;
+	}
+	//Fall back to generating a solution for each exit separately if the pivot search didn't find anything in time
 	std::vector<std::shared_ptr<Generate>> gens;
 	for (int i = 0; i < 3; i++) gens.push_back(std::make_shared<Generate>());
 	for (std::shared_ptr<Generate> gen : gens) {
@@ -1379,7 +1434,117 @@ void Special::generateSymmetryGate(int id)
 	WriteArray(id, REFLECTION_DATA, symData);
 }
 
+#define DOT_BOARD_WORDS 8 // Number of 64-bit words in a dot bitboard. Panels with more grid cells than this fall back to the reference check.
+
+//Bitboard over the grid of a panel, one bit per cell, indexed by x + y * width
+struct DotBoard {
+	uint64_t w[DOT_BOARD_WORDS] = {};
+
+	void set(int i) { w[i >> 6] |= 1ULL << (i & 63); }
+	bool any() const { for (uint64_t word : w) if (word) return true; return false; }
+	DotBoard operator&(const DotBoard& o) const { DotBoard r; for (int i = 0; i < DOT_BOARD_WORDS; i++) r.w[i] = w[i] & o.w[i]; return r; }
+	DotBoard operator|(const DotBoard& o) const { DotBoard r; for (int i = 0; i < DOT_BOARD_WORDS; i++) r.w[i] = w[i] | o.w[i]; return r; }
+	//Bit i of the result is bit i + n of this board (n may be negative)
+	DotBoard shift(int n) const {
+		DotBoard r;
+		int words = (n < 0 ? -n : n) >> 6, bits = (n < 0 ? -n : n) & 63;
+		for (int i = 0; i < DOT_BOARD_WORDS; i++) {
+			int src = n < 0 ? i - words : i + words;
+			if (src < 0 || src >= DOT_BOARD_WORDS) continue;
+			if (n < 0) r.w[i] = (w[src] << bits) | (bits && src > 0 ? w[src - 1] >> (64 - bits) : 0);
+			else r.w[i] = (w[src] >> bits) | (bits && src + 1 < DOT_BOARD_WORDS ? w[src + 1] << (64 - bits) : 0);
+		}
+		return r;
+	}
+};
+
+//Masks that only depend on the panel sizes, so they are only computed once for each size
+struct DotLayout {
+	DotBoard notLastColumn, notFirstColumn, intersections, blocks;
+	std::map<Panel::Symmetry, std::vector<int>> inverse; //For each symmetry, maps a cell of panel2 to the panel1 cell that reflects onto it (or -1)
+};
+
 bool Special::checkDotSolvability(std::shared_ptr<Panel> panel1, std::shared_ptr<Panel> panel2, Panel::Symmetry correctSym) {
+	bool solvable = checkDotSolvabilityBitboard(panel1, panel2, correctSym);
+#if _DEBUG
+	//Debug builds check every answer against the original version, and go with the original if they disagree
+	bool reference = checkDotSolvabilityReference(panel1, panel2, correctSym);
+	if (solvable != reference) {
+		OutputDebugStringW(L"checkDotSolvability: bitboard and reference versions disagree");
+		return reference;
+	}
+#endif
+	return solvable;
+}
+
+bool Special::checkDotSolvabilityBitboard(std::shared_ptr<Panel> panel1, std::shared_ptr<Panel> panel2, Panel::Symmetry correctSym) {
+	int width = panel1->_width, height = panel1->_height, width2 = panel2->_width, height2 = panel2->_height;
+	if (width * height > DOT_BOARD_WORDS * 64)
+		return checkDotSolvabilityReference(panel1, panel2, correctSym);
+	std::vector<Panel::Symmetry> sym = { Panel::Symmetry::FlipXY, Panel::Symmetry::FlipNegXY, Panel::Symmetry::RotateLeft, Panel::Symmetry::RotateRight };
+	//Each generation thread keeps its own layouts, so that no lock is needed
+	static thread_local std::map<std::vector<int>, DotLayout> layouts;
+	std::vector<int> key = { width, height, width2, height2 };
+	auto found = layouts.find(key);
+	if (found == layouts.end()) {
+		DotLayout layout;
+		for (int x = 0; x < width; x++) {
+			for (int y = 0; y < height; y++) {
+				int i = x + y * width;
+				if (x < width - 1) layout.notLastColumn.set(i);
+				if (x > 0) layout.notFirstColumn.set(i);
+				if (x % 2 == 0 && y % 2 == 0) layout.intersections.set(i);
+				if (x % 2 == 1 && y % 2 == 1) layout.blocks.set(i);
+			}
+		}
+		for (Panel::Symmetry s : sym) {
+			std::vector<int>& inverse = layout.inverse[s];
+			inverse = std::vector<int>(width2 * height2, -1);
+			for (int x = 0; x < width; x++) {
+				for (int y = 0; y < height; y++) {
+					Point sp = panel1->get_sym_point(x, y, s);
+					if (sp.first < 0 || sp.second < 0 || sp.first >= width2 || sp.second >= height2) continue;
+					inverse[sp.first + sp.second * width2] = x + y * width;
+				}
+			}
+		}
+		found = layouts.emplace(key, layout).first;
+	}
+	const DotLayout& layout = found->second;
+	//Visible dots of panel1 as a bitboard, and visible dots of panel2 as a list since they have to be moved by each symmetry
+	DotBoard dots1;
+	std::vector<int> dots2;
+	for (int x = 0; x < width; x++) {
+		for (int y = 0; y < height; y++) {
+			if ((panel1->_grid[x][y] & Decoration::Dot) && !(panel1->_grid[x][y] & IntersectionFlags::DOT_IS_INVISIBLE)) dots1.set(x + y * width);
+		}
+	}
+	for (int x = 0; x < width2; x++) {
+		for (int y = 0; y < height2; y++) {
+			if ((panel2->_grid[x][y] & Decoration::Dot) && !(panel2->_grid[x][y] & IntersectionFlags::DOT_IS_INVISIBLE)) dots2.push_back(x + y * width2);
+		}
+	}
+	for (Panel::Symmetry s : sym) {
+		if (s == correctSym) continue;
+		const std::vector<int>& inverse = layout.inverse.at(s);
+		DotBoard dots = dots1;
+		for (int d : dots2) {
+			if (inverse[d] >= 0) dots.set(inverse[d]);
+		}
+		//Shift the dots onto their neighbouring cells, then count neighbours with bitwise logic
+		DotBoard right = dots.shift(1) & layout.notLastColumn, left = dots.shift(-1) & layout.notFirstColumn;
+		DotBoard down = dots.shift(width), up = dots.shift(-width);
+		DotBoard three = (right & left & (down | up)) | (down & up & (right | left));
+		DotBoard four = right & left & down & up;
+		//Three dots at a point, or four dots in a circle
+		if (!((three & layout.intersections) | (four & layout.blocks)).any())
+			return true;
+	}
+	return false;
+}
+
+//Original version of checkDotSolvability, kept to check the bitboard version against
+bool Special::checkDotSolvabilityReference(std::shared_ptr<Panel> panel1, std::shared_ptr<Panel> panel2, Panel::Symmetry correctSym) {
 	std::vector<Panel::Symmetry> sym = { Panel::Symmetry::FlipXY, Panel::Symmetry::FlipNegXY, Panel::Symmetry::RotateLeft, Panel::Symmetry::RotateRight };
 	for (Panel::Symmetry s : sym) {
 		if (s == correctSym) continue;
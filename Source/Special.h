@@ -49,7 +49,7 @@ public:
 	bool generate2BridgeH(int id1, int id2, std::vector<std::shared_ptr<Generate>> gens);
 	void generateMountainFloor();
 	void generateMountainFloorH();
-	void generatePivotPanel(int id, Point gridSize, const std::vector<std::pair<int, int>>& symbolVec, bool colorblind); //Too slow right now, only used a couple times in hard mode
+	void generatePivotPanel(int id, Point gridSize, const std::vector<std::pair<int, int>>& symbolVec, bool colorblind);
 	void modifyGate(int id);
 	void addDecoyExits(std::shared_ptr<Generate> gen, int amount);
 	void initSSGrid(std::shared_ptr<Generate> gen);
@@ -57,6 +57,8 @@ public:
 	void initPillarSymmetry(std::shared_ptr<Generate> gen, int id, Panel::Symmetry symmetry);
 	void generateSymmetryGate(int id);
 	bool checkDotSolvability(std::shared_ptr<Panel> panel1, std::shared_ptr<Panel> panel2, Panel::Symmetry correctSym);
+	bool checkDotSolvabilityBitboard(std::shared_ptr<Panel> panel1, std::shared_ptr<Panel> panel2, Panel::Symmetry correctSym);
+	bool checkDotSolvabilityReference(std::shared_ptr<Panel> panel1, std::shared_ptr<Panel> panel2, Panel::Symmetry correctSym);
 	void createArrowPuzzle(int id, int x, int y, int dir, int ticks, const std::vector<Point>& gaps);
 	void createArrowSecretDoor(int id);
 	void generateCenterPerspective(int id, const std::vector<std::pair<int, int>>& symbolVec, int symbolType);
@@ -111,56 +113,56 @@ public:
 	}
 	static void setTargetAndDeactivate(int puzzle, int target)
 	{
-		std::shared_ptr<Memory> _memory = std::make_shared<Memory>("witness64_d3d11.exe");
+		std::shared_ptr<Memory> _memory = Memory::get();
 		if (!hasBeenRandomized()) //Only deactivate on a fresh save file (since power state is preserved)
 			_memory->WritePanelData<float>(target, POWER, { 0.0, 0.0 });
 		WritePanelData(puzzle, TARGET, target + 1);
 	}
 	static void setPower(int puzzle, bool power) {
 
-		std::shared_ptr<Memory> _memory = std::make_shared<Memory>("witness64_d3d11.exe");
+		std::shared_ptr<Memory> _memory = Memory::get();
 		if (!power && hasBeenRandomized()) return; //Only deactivate on a fresh save file (since power state is preserved)
 		if (power) _memory->WritePanelData<float>(puzzle, POWER, { 1.0, 1.0 });
 		else _memory->WritePanelData<float>(puzzle, POWER, { 0.0, 0.0 });
 	}
 	template <class T> static std::vector<T> ReadPanelData(int panel, int offset, size_t size) {
-		std::shared_ptr<Memory> _memory = std::make_shared<Memory>("witness64_d3d11.exe"); return _memory->ReadPanelData<T>(panel, offset, size);
+		std::shared_ptr<Memory> _memory = Memory::get(); return _memory->ReadPanelData<T>(panel, offset, size);
 	}
 	template <class T> T static ReadPanelData(int panel, int offset) {
-		std::shared_ptr<Memory> _memory = std::make_shared<Memory>("witness64_d3d11.exe"); return _memory->ReadPanelData<T>(panel, offset);
+		std::shared_ptr<Memory> _memory = Memory::get(); return _memory->ReadPanelData<T>(panel, offset);
 	}
 	template <class T> static std::vector<T> ReadArray(int panel, int offset, int size) {
-		std::shared_ptr<Memory> _memory = std::make_shared<Memory>("witness64_d3d11.exe"); return _memory->ReadArray<T>(panel, offset, size);
+		std::shared_ptr<Memory> _memory = Memory::get(); return _memory->ReadArray<T>(panel, offset, size);
 	}
 	static void WritePanelData(int panel, int offset, char data) {
-		std::shared_ptr<Memory> _memory = std::make_shared<Memory>("witness64_d3d11.exe"); return _memory->WritePanelData<char>(panel, offset, { data });
+		std::shared_ptr<Memory> _memory = Memory::get(); return _memory->WritePanelData<char>(panel, offset, { data });
 	}
 	static void WritePanelData(int panel, int offset, int data) {
-		std::shared_ptr<Memory> _memory = std::make_shared<Memory>("witness64_d3d11.exe"); return _memory->WritePanelData<int>(panel, offset, { data });
+		std::shared_ptr<Memory> _memory = Memory::get(); return _memory->WritePanelData<int>(panel, offset, { data });
 	}
 	static void WritePanelData(int panel, int offset, float data) {
-		std::shared_ptr<Memory> _memory = std::make_shared<Memory>("witness64_d3d11.exe"); return _memory->WritePanelData<float>(panel, offset, { data });
+		std::shared_ptr<Memory> _memory = Memory::get(); return _memory->WritePanelData<float>(panel, offset, { data });
 	}
 	static void WritePanelData(int panel, int offset, Color data) {
-		std::shared_ptr<Memory> _memory = std::make_shared<Memory>("witness64_d3d11.exe"); return _memory->WritePanelData<Color>(panel, offset, { data });
+		std::shared_ptr<Memory> _memory = Memory::get(); return _memory->WritePanelData<Color>(panel, offset, { data });
 	}
 	static void WriteArray(int panel, int offset, const std::vector<int>& data) {
 		return WriteArray(panel, offset, data, false);
 	}
 	static void WriteArray(int panel, int offset, const std::vector<int>& data, bool force) {
-		std::shared_ptr<Memory> _memory = std::make_shared<Memory>("witness64_d3d11.exe"); return _memory->WriteArray<int>(panel, offset, data, force);
+		std::shared_ptr<Memory> _memory = Memory::get(); return _memory->WriteArray<int>(panel, offset, data, force);
 	}
 	static void WriteArray(int panel, int offset, const std::vector<float>& data) {
 		return WriteArray(panel, offset, data, false);
 	}
 	static void WriteArray(int panel, int offset, const std::vector<float>& data, bool force) {
-		std::shared_ptr<Memory> _memory = std::make_shared<Memory>("witness64_d3d11.exe"); return _memory->WriteArray<float>(panel, offset, data, force);
+		std::shared_ptr<Memory> _memory = Memory::get(); return _memory->WriteArray<float>(panel, offset, data, force);
 	}
 	static void WriteArray(int panel, int offset, const std::vector<Color>& data) {
 		return WriteArray(panel, offset, data, false);
 	}
 	static void WriteArray(int panel, int offset, const std::vector<Color>& data, bool force) {
-		std::shared_ptr<Memory> _memory = std::make_shared<Memory>("witness64_d3d11.exe"); return _memory->WriteArray<Color>(panel, offset, data, force);
+		std::shared_ptr<Memory> _memory = Memory::get(); return _memory->WriteArray<Color>(panel, offset, data, force);
 	}
 
 	static void testSwap(int id1, int id2) {
@@ -174,9 +176,9 @@ public:
 	}
 
 	template <class T> static std::vector<T> testRead(int address, int numItems) {
-		Memory memory("witness64_d3d11.exe");
+		std::shared_ptr<Memory> memory = Memory::get();
 		std::vector<int> offsets = { address };
-		return memory.ReadData<T>(offsets, numItems);
+		return memory->ReadData<T>(offsets, numItems);
 	}
 
 	static void testPanel(int id) {
@@ -185,7 +187,7 @@ public:
 	}
 
 	template <class T> static uintptr_t testFind(uintptr_t startAddress, int length, T item) {
-		Memory memory("witness64_d3d11.exe");
+		std::shared_ptr<Memory> memory = Memory::get();
 		uintptr_t address;
 		std::vector<byte> bytes;
 		bytes.resize(1024, 0);
@@ -193,7 +195,7 @@ public:
 		itemb.resize(sizeof(T));
 		std::memcpy(&itemb[0], &item, sizeof(T));
 		for (address = startAddress; address < startAddress + length; address += 1024) {
-			if (!memory.ReadAbsolute(reinterpret_cast<LPCVOID>(address), &bytes[0], 1024))
+			if (!memory->ReadAbsolute(reinterpret_cast<LPCVOID>(address), &bytes[0], 1024))
 				continue;
 			for (int i = 0; i < bytes.size() - itemb.size(); i += sizeof(T)) {
 				if (std::equal(bytes.begin() + i, bytes.begin() + i + sizeof(T), itemb.begin()))
@@ -204,7 +206,7 @@ public:
 	}
 
 	template <class T> static uintptr_t testFind2(uintptr_t startAddress, int length, T item) {
-		Memory memory("witness64_d3d11.exe");
+		std::shared_ptr<Memory> memory = Memory::get();
 		uintptr_t address;
 		std::vector<byte> bytes;
 		bytes.resize(1024, 0);
@@ -212,7 +214,7 @@ public:
 		itemb.resize(sizeof(T) - 1);
 		std::memcpy(&itemb[0], &item, sizeof(T) - 1);
 		for (address = startAddress; address < startAddress + length; address += 1024) {
-			if (!memory.ReadAbsolute(reinterpret_cast<LPCVOID>(address), &bytes[0], 1024))
+			if (!memory->ReadAbsolute(reinterpret_cast<LPCVOID>(address), &bytes[0], 1024))
 				continue;
 			for (int i = 0; i < bytes.size() - itemb.size() + 1; i += sizeof(T)) {
 				if (std::equal(bytes.begin() + i, bytes.begin() + i + sizeof(T) - 1, itemb.begin()))
@@ -0,0 +1,121 @@
+// This is an open source non-commercial project. Dear PVS-Studio, please check it.
+
+// PVS-Studio Static Code Analyzer for C, C++, C#, and Java: http://www.viva64.com
+
+#include "StartupPipeline.h"
+#include <algorithm>
+#include <condition_variable>
+#include <exception>
+#include <iomanip>
+#include <mutex>
+#include <sstream>
+#include <stdexcept>
+#include <thread>
+
+void StartupPipeline::add(const std::string& name, const std::vector<std::string>& after, std::function<void()> run) {
+	std::vector<size_t> waitsFor;
+	for (const std::string& dependency : after) {
+		auto search = std::find_if(_phases.begin(), _phases.end(), [&](const StartupPhase& phase) { return phase.name == dependency; });
+		if (search == _phases.end()) throw std::invalid_argument("Startup phase " + name + " waits for unknown phase " + dependency);
+		waitsFor.push_back(search - _phases.begin());
+	}
+	StartupPhase phase;
+	phase.name = name;
+	phase.after = after;
+	phase.run = std::move(run);
+	_phases.push_back(std::move(phase));
+	_waitsFor.push_back(waitsFor);
+}
+
+void StartupPipeline::run() {
+	using namespace std::chrono;
+	steady_clock::time_point start = steady_clock::now();
+	std::mutex mtx;
+	std::condition_variable finished;
+	std::vector<std::thread> threads;
+	std::exception_ptr error;
+	size_t remaining = _phases.size();
+
+	std::unique_lock<std::mutex> lock(mtx);
+	while (remaining > 0) {
+		bool progress = false;
+		for (size_t i = 0; i < _phases.size(); i++) {
+			StartupPhase& phase = _phases[i];
+			if (phase.state != PhaseState::Pending) continue;
+			bool ready = true;
+			bool skip = false;
+			for (size_t dependency : _waitsFor[i]) {
+				PhaseState state = _phases[dependency].state;
+				ready = ready && state == PhaseState::Done;
+				skip = skip || state == PhaseState::Failed || state == PhaseState::Skipped;
+			}
+			if (skip) {
+				phase.state = PhaseState::Skipped;
+				remaining--;
+				progress = true;
+			}
+			else if (ready) {
+				phase.state = PhaseState::Running;
+				phase.start = duration_cast<microseconds>(steady_clock::now() - start);
+				threads.emplace_back([&, i]() {
+					StartupPhase& phase = _phases[i];
+					std::exception_ptr thrown;
+					try {
+						phase.run();
+					}
+					catch (...) {
+						thrown = std::current_exception();
+					}
+					std::lock_guard<std::mutex> lock(mtx);
+					phase.duration = duration_cast<microseconds>(steady_clock::now() - start) - phase.start;
+					phase.state = thrown ? PhaseState::Failed : PhaseState::Done;
+					if (thrown && !error) error = thrown;
+					remaining--;
+					finished.notify_one();
+				});
+				progress = true;
+			}
+		}
+		// Skipping a phase can make others skippable, so look again before waiting
+		if (!progress && remaining > 0) finished.wait(lock);
+	}
+	lock.unlock();
+
+	for (std::thread& thread : threads) thread.join();
+	_total = duration_cast<microseconds>(steady_clock::now() - start);
+	if (error) std::rethrow_exception(error);
+}
+
+static const char* stateName(PhaseState state) {
+	switch (state) {
+	case PhaseState::Pending: return "pending";
+	case PhaseState::Running: return "running";
+	case PhaseState::Done: return "done";
+	case PhaseState::Failed: return "failed";
+	case PhaseState::Skipped: return "skipped";
+	}
+	return "";
+}
+
+std::string StartupPipeline::report() const {
+	std::vector<const StartupPhase*> byStart;
+	for (const StartupPhase& phase : _phases) byStart.push_back(&phase);
+	// Skipped phases never started, so they go last
+	std::stable_sort(byStart.begin(), byStart.end(), [](const StartupPhase* a, const StartupPhase* b) {
+		bool aSkipped = a->state == PhaseState::Skipped, bSkipped = b->state == PhaseState::Skipped;
+		return aSkipped != bSkipped ? bSkipped : a->start < b->start;
+	});
+
+	std::ostringstream ss;
+	ss << std::fixed << std::setprecision(1);
+	ss << std::left << std::setw(32) << "phase" << std::setw(9) << "state" << std::right << std::setw(12) << "start ms" << std::setw(12) << "took ms"
+		<< "  after\n";
+	for (const StartupPhase* phase : byStart) {
+		std::string after;
+		for (const std::string& dependency : phase->after) after += (after.empty() ? "" : ", ") + dependency;
+		ss << std::left << std::setw(32) << phase->name << std::setw(9) << stateName(phase->state) << std::right
+			<< std::setw(12) << phase->start.count() / 1000.0 << std::setw(12) << phase->duration.count() / 1000.0 << "  " << after << "\n";
+	}
+	ss << std::left << std::setw(41) << "total" << std::right << std::setw(24) << _total.count() / 1000.0 << "\n";
+	return ss.str();
+}
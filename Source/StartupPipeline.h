@@ -0,0 +1,46 @@
+#pragma once
+#include <chrono>
+#include <functional>
+#include <string>
+#include <vector>
+
+enum class PhaseState {
+	Pending,
+	Running,
+	Done,
+	Failed, // Threw
+	Skipped, // A phase it waits for failed or was skipped
+};
+
+// One step of a pipeline, and how it went.
+struct StartupPhase {
+	std::string name;
+	std::vector<std::string> after; // Phases that must be done before this one starts
+	std::function<void()> run;
+	PhaseState state = PhaseState::Pending;
+	std::chrono::microseconds start = {}; // Since the pipeline started
+	std::chrono::microseconds duration = {};
+};
+
+// Runs a set of phases in dependency order. Each phase gets a thread of its own as soon as the phases it waits for are done, so phases
+//   that don't depend on each other run at the same time. Every phase is timed, so slow startups can be told apart.
+class StartupPipeline
+{
+public:
+	// Phases can only wait for phases added before them.
+	void add(const std::string& name, const std::vector<std::string>& after, std::function<void()> run);
+
+	// Run every phase and wait for all of them. If a phase throws, the phases waiting for it are skipped, and the first exception is
+	//   rethrown once everything else has finished.
+	void run();
+
+	const std::vector<StartupPhase>& phases() const { return _phases; }
+	std::chrono::microseconds total() const { return _total; }
+	// The phases as a table, in the order they started, then the ones that were skipped.
+	std::string report() const;
+
+private:
+	std::vector<StartupPhase> _phases;
+	std::vector<std::vector<size_t>> _waitsFor; // Indices into _phases, by phase
+	std::chrono::microseconds _total = {};
+};
@@ -0,0 +1,112 @@
+// This is an open source non-commercial project. Dear PVS-Studio, please check it.
+
+// PVS-Studio Static Code Analyzer for C, C++, C#, and Java: http://www.viva64.com
+
+#include "Utilities.h"
+#include <algorithm>
+
+#if defined(_M_X64) || defined(__SSE2__)
+#include <emmintrin.h>
+#define UTILITIES_SSE2
+#endif
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+// Bytes that show up the most in the game's code, most common first. Anything else counts as rare.
+static const uint8_t commonBytes[] = {
+	0x00, 0xFF, 0x48, 0x8B, 0x89, 0x24, 0x0F, 0x4C, 0x44, 0x83, 0x01, 0xCC, 0x8D, 0xE8, 0x85,
+	0x10, 0x08, 0x20, 0xC0, 0x40, 0x41, 0x49, 0x74, 0x45, 0x18, 0x0D, 0x05, 0xC3, 0x3F, 0x80,
+};
+
+static int commonness(uint8_t value) {
+	for (int i = 0; i < sizeof(commonBytes); i++) {
+		if (commonBytes[i] == value) return static_cast<int>(sizeof(commonBytes)) - i;
+	}
+	return 0;
+}
+
+#ifdef UTILITIES_SSE2
+static int lowestBit(unsigned int bits) {
+#ifdef _MSC_VER
+	unsigned long index;
+	_BitScanForward(&index, bits);
+	return static_cast<int>(index);
+#else
+	return __builtin_ctz(bits);
+#endif
+}
+#endif
+
+int Utilities::findSequence(const std::vector<uint8_t>& sourceData, const std::vector<uint8_t>& searchSequence, const std::string& mask, int startIndex, int endIndex) {
+	int length = static_cast<int>(searchSequence.size());
+	if (mask.size() != searchSequence.size()) return -1;
+	startIndex = std::max(startIndex, 0);
+	endIndex = std::min(endIndex, static_cast<int>(sourceData.size()) - length + 1);
+	if (startIndex >= endIndex) return -1;
+
+	// Candidates are found by looking for the two rarest exact bytes, and then checked against the whole sequence.
+	int first = -1, second = -1;
+	for (int i = 0; i < length; i++) {
+		if (mask[i] == '?') continue;
+		if (first == -1 || commonness(searchSequence[i]) < commonness(searchSequence[first])) {
+			second = first;
+			first = i;
+		}
+		else if (second == -1 || commonness(searchSequence[i]) < commonness(searchSequence[second])) {
+			second = i;
+		}
+	}
+	if (first == -1) return startIndex; // Nothing but wildcards
+	if (second == -1) second = first;
+
+	const uint8_t* data = sourceData.data();
+	int index = startIndex;
+
+#ifdef UTILITIES_SSE2
+	// The sequence and its mask in 16 byte blocks, so that candidates are checked a block at a time. Bytes after the last full block are compared one by one.
+	int blocks = length / 16;
+	std::vector<uint8_t> blockBytes(searchSequence.begin(), searchSequence.begin() + blocks * 16);
+	std::vector<uint8_t> blockMask(blocks * 16);
+	for (int i = 0; i < blocks * 16; i++) blockMask[i] = mask[i] == '?' ? 0x00 : 0xFF;
+
+	auto matches = [&](int candidate) {
+		for (int block = 0; block < blocks; block++) {
+			__m128i actual = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + candidate + block * 16));
+			__m128i expected = _mm_loadu_si128(reinterpret_cast<const __m128i*>(&blockBytes[block * 16]));
+			__m128i care = _mm_loadu_si128(reinterpret_cast<const __m128i*>(&blockMask[block * 16]));
+			__m128i different = _mm_andnot_si128(_mm_cmpeq_epi8(actual, expected), care);
+			if (_mm_movemask_epi8(different) != 0) return false;
+		}
+		for (int i = blocks * 16; i < length; i++) {
+			if (mask[i] != '?' && data[candidate + i] != searchSequence[i]) return false;
+		}
+		return true;
+	};
+
+	const __m128i firstByte = _mm_set1_epi8(static_cast<char>(searchSequence[first]));
+	const __m128i secondByte = _mm_set1_epi8(static_cast<char>(searchSequence[second]));
+	for (; index + 16 <= endIndex; index += 16) {
+		__m128i atFirst = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + index + first));
+		__m128i atSecond = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + index + second));
+		unsigned int candidates = _mm_movemask_epi8(_mm_and_si128(_mm_cmpeq_epi8(atFirst, firstByte), _mm_cmpeq_epi8(atSecond, secondByte)));
+		while (candidates != 0) {
+			int candidate = index + lowestBit(candidates);
+			if (matches(candidate)) return candidate;
+			candidates &= candidates - 1;
+		}
+	}
+#else
+	auto matches = [&](int candidate) {
+		for (int i = 0; i < length; i++) {
+			if (mask[i] != '?' && data[candidate + i] != searchSequence[i]) return false;
+		}
+		return true;
+	};
+#endif
+
+	for (; index < endIndex; index++) {
+		if (data[index + first] == searchSequence[first] && data[index + second] == searchSequence[second] && matches(index)) return index;
+	}
+	return -1;
+}
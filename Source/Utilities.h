@@ -1,5 +1,7 @@
 #pragma once
 
+#include <cstdint>
+#include <string>
 #include <vector>
 
 class Utilities {
@@ -28,6 +30,15 @@ public:
 		return -1;
 	}
 
+	// Byte sequences are searched for with SSE2 instead, since they are what every signature scan is made of.
+	static int findSequence(const std::vector<uint8_t>& sourceData, const std::vector<uint8_t>& searchSequence, int startIndex, int endIndex) {
+		return findSequence(sourceData, searchSequence, std::string(searchSequence.size(), 'x'), startIndex, endIndex);
+	}
+
+	// Find the first instance of a byte sequence in which some bytes can be anything. In mask, 'x' means the byte has to match and '?' means
+	//   any byte is accepted. Returns -1 if no instance starts in [startIndex, endIndex).
+	static int findSequence(const std::vector<uint8_t>& sourceData, const std::vector<uint8_t>& searchSequence, const std::string& mask, int startIndex, int endIndex);
+
 	// Find the first instance of a search sequence within the entirety of the source data.
 	template<typename T>
 	static int findSequence(const std::vector<T>& sourceData, const std::vector<T>& searchSequence) {
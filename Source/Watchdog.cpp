@@ -3,20 +3,39 @@
 // PVS-Studio Static Code Analyzer for C, C++, C#, and Java: http://www.viva64.com
 
 #include "Watchdog.h"
+#include "MemoryWatch.h"
+#include "PanelSchema.h"
 #include "Quaternion.h"
-#include <thread>
+
+#define ARROW_WATCH_MS 10 // How often watched arrow puzzles check their traced edges. One batched read covers all of them.
 
 void Watchdog::start()
 {
-	std::thread{ &Watchdog::run, this }.detach();
+	if (_dedicated) {
+		_thread = std::thread([this]() {
+			while (!terminate && !_stopping) {
+				std::this_thread::sleep_for(std::chrono::milliseconds(static_cast<int>(sleepTime * 1000)));
+				if (!_stopping) action();
+			}
+		});
+		return;
+	}
+	auto seconds = [](float time) { return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::duration<float>(time)); };
+	_task = WatchdogScheduler::get().schedule(seconds(sleepTime), [this, seconds](std::chrono::nanoseconds& interval) {
+		action();
+		interval = seconds(sleepTime);
+		return !terminate;
+	});
 }
 
-void Watchdog::run()
+void Watchdog::stop()
 {
-	while (!terminate) {
-		std::this_thread::sleep_for(std::chrono::milliseconds(static_cast<int>(sleepTime * 1000)));
-		action();
-	}
+	if (_task) WatchdogScheduler::get().cancel(_task);
+	if (!_thread.joinable()) return;
+	_stopping = true;
+	// Like a tick cancelling its own task, an action stopping its own watchdog is finished off once it returns
+	if (_thread.get_id() == std::this_thread::get_id()) _thread.detach();
+	else _thread.join();
 }
 
 //Keep Watchdog - Keep the big panel off until all panels are solved
@@ -35,7 +54,17 @@ void KeepWatchdog::action() {
 //Arrow Watchdog - To run the arrow puzzles
 
 void ArrowWatchdog::action() {
-	int length = ReadPanelDataIntentionallyUnsafe<int>(id, TRACED_EDGES);
+	update(ReadPanelDataIntentionallyUnsafe<int>(id, TRACED_EDGES));
+}
+
+void ArrowWatchdog::watch() {
+	MemoryWatchRegistry::get().watch(id, PanelFields::TracedEdges, std::chrono::milliseconds(ARROW_WATCH_MS), [this](int, int length) {
+		update(length);
+		return true;
+	}, true);
+}
+
+void ArrowWatchdog::update(int length) {
 	if (length != tracedLength) {
 		complete = false;
 	}
@@ -201,15 +230,6 @@ bool BridgeWatchdog::checkTouch(int id)
 	return false;
 }
 
-void TreehouseWatchdog::action()
-{
-	if (ReadPanelData<int>(0x03613, SOLVED)) {
-		WritePanelData<float>(0x17DAE, POWER, { 1.0f, 1.0f });
-		WritePanelData<int>(0x17DAE, NEEDS_REDRAW, { 1 });
-		terminate = true;
-	}
-}
-
 void JungleWatchdog::action()
 {
 	int numTraced = ReadPanelData<int>(id, TRACED_EDGES);
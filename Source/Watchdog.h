@@ -3,17 +3,25 @@
 #include "Panel.h"
 #include "Randomizer.h"
 #include "Generate.h"
+#include "WatchdogScheduler.h"
+#include <atomic>
+#include <thread>
 
 class Watchdog
 {
 public:
-	Watchdog(float time) {
+	// A dedicated watchdog runs on a thread of its own instead of the shared scheduler, for actions that can block for seconds (waiting on
+	//   the server or on the game), which would otherwise keep the scheduler's threads from running everyone else's ticks.
+	Watchdog(float time, bool dedicated = false) {
 		terminate = false;
 		sleepTime = time;
-		_memory = std::make_shared<Memory>("witness64_d3d11.exe");
+		_dedicated = dedicated;
+		_memory = Memory::get();
 	};
+	// Run action every sleepTime seconds, until terminate is set or stop is called.
 	void start();
-	void run();
+	// Once this returns, action isn't running and won't run again.
+	void stop();
 	virtual void action() = 0;
 	float sleepTime;
 	bool terminate;
@@ -24,15 +32,17 @@ protected:
 		}
 		catch (std::exception& e) {
 			OutputDebugStringW(L"Watchdog Read Problem");
+			return std::vector<T>(size);
 		}
 	}
+	//Gives T() if the read failed, so that the watchdog just sees nothing happening until the game is readable again
 	template <class T> T ReadPanelData(int panel, int offset) const {
-		try {
-			return _memory->ReadPanelData<T>(panel, offset);
-		}
-		catch (std::exception& e) {
+		T value = T();
+		if (_memory->TryReadPanelData<T>(panel, offset, value) != MemoryError::None) {
 			OutputDebugStringW(L"Watchdog Read Problem");
+			return T();
 		}
+		return value;
 	}
 	template <class T> T ReadPanelDataIntentionallyUnsafe(int panel, int offset) const {
 		return _memory->ReadPanelData<T>(panel, offset);
@@ -43,6 +53,7 @@ protected:
 		}
 		catch (std::exception& e) {
 			OutputDebugStringW(L"Watchdog Read Array Problem");
+			return std::vector<T>();
 		}
 	}
 	template <class T> void WritePanelData(int panel, int offset, const std::vector<T>& data) const {
@@ -70,6 +81,10 @@ protected:
 		}
 	}
 	std::shared_ptr<Memory> _memory;
+	uint64_t _task = 0; // Id on the scheduler, once started
+	bool _dedicated;
+	std::thread _thread; // Runs action, for a dedicated watchdog
+	std::atomic<bool> _stopping = false;
 };
 
 class KeepWatchdog : public Watchdog {
@@ -98,6 +113,11 @@ public:
 		if (pillarWidth > 0) exitPoint = (width / 2) * (height / 2 + 1);
 	}
 	virtual void action();
+	// Follow the traced edges through the shared MemoryWatchRegistry instead of polling them with start(). Unlike start(), a game that
+	//   can't be read is waited out rather than ending the randomizer.
+	void watch();
+	// React to the player having traced length edges.
+	void update(int length);
 	void initPath();
 	bool checkArrow(int x, int y);
 	bool checkArrowPillar(int x, int y);
@@ -125,12 +145,6 @@ public:
 	int id1, id2, solLength1, solLength2;
 };
 
-class TreehouseWatchdog : public Watchdog {
-public:
-	TreehouseWatchdog(int id) : Watchdog(1) { }
-	virtual void action();
-};
-
 class JungleWatchdog : public Watchdog {
 public:
 	JungleWatchdog(int id, std::vector<int> correctSeq1, std::vector<int> correctSeq2) : Watchdog(0.5f) {
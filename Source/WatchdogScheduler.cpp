@@ -0,0 +1,202 @@
+// This is an open source non-commercial project. Dear PVS-Studio, please check it.
+
+// PVS-Studio Static Code Analyzer for C, C++, C#, and Java: http://www.viva64.com
+
+#include "WatchdogScheduler.h"
+#include <algorithm>
+
+using std::chrono::nanoseconds;
+
+static const nanoseconds resolution = std::chrono::microseconds(SCHEDULER_RESOLUTION_US);
+
+static thread_local uint64_t currentTask = 0; // The task whose tick this thread is running, if any
+
+// The first wheel tick at or after the given time
+static uint64_t wheelTick(nanoseconds time) {
+	if (time.count() <= 0) return 0;
+	return static_cast<uint64_t>((time.count() + resolution.count() - 1) / resolution.count());
+}
+
+WatchdogScheduler::WatchdogScheduler(int threads) {
+	std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+	_clock = [start]() { return std::chrono::duration_cast<nanoseconds>(std::chrono::steady_clock::now() - start); };
+	_threads.emplace_back(&WatchdogScheduler::timerLoop, this);
+	for (int i = 0; i < threads; i++) _threads.emplace_back(&WatchdogScheduler::workerLoop, this);
+}
+
+WatchdogScheduler::WatchdogScheduler(Clock clock) : _clock(clock) {
+	_nextTick = std::max<int64_t>(_clock().count(), 0) / resolution.count();
+}
+
+WatchdogScheduler::~WatchdogScheduler() {
+	{
+		std::lock_guard<std::mutex> lock(_mtx);
+		_stopping = true;
+		for (auto& entry : _tasks) entry.second->cancelled = true;
+	}
+	_timer.notify_all();
+	_work.notify_all();
+	for (std::thread& thread : _threads) thread.join();
+}
+
+// Never destroyed, so that ticks still running when the program exits don't hold up its exit (as the watchdogs' own threads didn't)
+WatchdogScheduler& WatchdogScheduler::get() {
+	static WatchdogScheduler* scheduler = new WatchdogScheduler(SCHEDULER_THREADS);
+	return *scheduler;
+}
+
+uint64_t WatchdogScheduler::schedule(nanoseconds interval, Tick tick) {
+	std::lock_guard<std::mutex> lock(_mtx);
+	std::shared_ptr<Task> task = std::make_shared<Task>();
+	task->id = _nextId++;
+	task->tick = std::move(tick);
+	task->interval = std::max(interval, nanoseconds(1));
+	task->deadline = _clock() + task->interval;
+	_tasks[task->id] = task;
+	file(task);
+	_timer.notify_all();
+	return task->id;
+}
+
+void WatchdogScheduler::cancel(uint64_t id) {
+	std::unique_lock<std::mutex> lock(_mtx);
+	auto search = _tasks.find(id);
+	if (search == _tasks.end()) return;
+	std::shared_ptr<Task> task = search->second;
+	task->cancelled = true;
+	// A tick cancelling its own task is finished off once it returns
+	if (currentTask == id) return;
+	_finished.wait(lock, [&]() { return !task->running; });
+	_tasks.erase(id);
+}
+
+bool WatchdogScheduler::scheduled(uint64_t id) {
+	std::lock_guard<std::mutex> lock(_mtx);
+	auto search = _tasks.find(id);
+	return search != _tasks.end() && !search->second->cancelled;
+}
+
+ScheduledTaskStats WatchdogScheduler::stats(uint64_t id) {
+	std::lock_guard<std::mutex> lock(_mtx);
+	auto search = _tasks.find(id);
+	return search == _tasks.end() ? ScheduledTaskStats() : search->second->stats;
+}
+
+void WatchdogScheduler::file(const std::shared_ptr<Task>& task) {
+	task->slotTick = std::max(wheelTick(task->deadline), _nextTick);
+	_wheel[task->slotTick % SCHEDULER_WHEEL_SLOTS].push_back(task->id);
+}
+
+// Go through the slots of every wheel tick up to now, queueing the tasks that are due. The ones filed for a later turn stay put.
+void WatchdogScheduler::advance(nanoseconds now) {
+	while (static_cast<int64_t>(_nextTick) * resolution.count() <= now.count()) {
+		std::vector<uint64_t>& slot = _wheel[_nextTick % SCHEDULER_WHEEL_SLOTS];
+		std::vector<uint64_t> later;
+		for (uint64_t id : slot) {
+			auto search = _tasks.find(id);
+			if (search == _tasks.end() || search->second->cancelled) continue;
+			std::shared_ptr<Task>& task = search->second;
+			if (task->slotTick > _nextTick) {
+				later.push_back(id);
+				continue;
+			}
+			task->queued = true;
+			_ready.push_back(task);
+		}
+		slot.swap(later);
+		_nextTick++;
+	}
+}
+
+// Returns false if the task was cancelled before its tick could start.
+bool WatchdogScheduler::run(const std::shared_ptr<Task>& task) {
+	nanoseconds interval;
+	{
+		std::lock_guard<std::mutex> lock(_mtx);
+		task->queued = false;
+		if (task->cancelled) {
+			_tasks.erase(task->id);
+			return false;
+		}
+		task->running = true;
+		task->stats.runs++;
+		task->stats.maxLateness = std::max(task->stats.maxLateness, _clock() - task->deadline);
+		interval = task->interval;
+	}
+
+	currentTask = task->id;
+	bool keep = false;
+	try {
+		keep = task->tick(interval);
+	}
+	catch (...) {
+		currentTask = 0;
+		finish(task, false, interval);
+		throw;
+	}
+	currentTask = 0;
+	finish(task, keep, interval);
+	return true;
+}
+
+void WatchdogScheduler::finish(const std::shared_ptr<Task>& task, bool keep, nanoseconds interval) {
+	std::lock_guard<std::mutex> lock(_mtx);
+	task->running = false;
+	_finished.notify_all();
+	if (!keep || task->cancelled) {
+		_tasks.erase(task->id);
+		return;
+	}
+
+	task->interval = std::max(interval, nanoseconds(1));
+	nanoseconds now = _clock();
+	nanoseconds next = task->deadline + task->interval;
+	if (next <= now) {
+		// The ticks that fell due while this one ran are skipped, and the next one stays on the original schedule
+		uint64_t missed = static_cast<uint64_t>((now - task->deadline) / task->interval);
+		task->stats.overruns++;
+		task->stats.missed += missed;
+		next = task->deadline + task->interval * static_cast<int64_t>(missed + 1);
+	}
+	task->deadline = next;
+	file(task);
+}
+
+int WatchdogScheduler::runDue() {
+	int count = 0;
+	while (true) {
+		std::deque<std::shared_ptr<Task>> ready;
+		{
+			std::lock_guard<std::mutex> lock(_mtx);
+			advance(_clock());
+			ready.swap(_ready);
+		}
+		if (ready.empty()) return count;
+		for (const std::shared_ptr<Task>& task : ready) {
+			if (run(task)) count++;
+		}
+	}
+}
+
+void WatchdogScheduler::timerLoop() {
+	std::unique_lock<std::mutex> lock(_mtx);
+	while (!_stopping) {
+		advance(_clock());
+		if (!_ready.empty()) _work.notify_all();
+		if (_tasks.empty()) _timer.wait(lock);
+		else _timer.wait_for(lock, nanoseconds(static_cast<int64_t>(_nextTick) * resolution.count()) - _clock());
+	}
+}
+
+void WatchdogScheduler::workerLoop() {
+	std::unique_lock<std::mutex> lock(_mtx);
+	while (true) {
+		_work.wait(lock, [this]() { return _stopping || !_ready.empty(); });
+		if (_stopping) return;
+		std::shared_ptr<Task> task = _ready.front();
+		_ready.pop_front();
+		lock.unlock();
+		run(task);
+		lock.lock();
+	}
+}
@@ -0,0 +1,93 @@
+#pragma once
+#include <array>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#define SCHEDULER_THREADS          4 // Threads the shared scheduler runs ticks on
+#define SCHEDULER_RESOLUTION_US 5000 // Microseconds per slot of the timer wheel. Ticks are run at most this late, plus however long the pool is busy.
+#define SCHEDULER_WHEEL_SLOTS    256 // One turn of the wheel is 1.28 s. Tasks further out than that stay in their slot for more turns.
+
+// How a scheduled task has been keeping up.
+struct ScheduledTaskStats {
+	uint64_t runs = 0;
+	uint64_t overruns = 0; // Times a tick finished after the next one was due
+	uint64_t missed = 0; // Ticks skipped because of overruns
+	std::chrono::nanoseconds maxLateness = {}; // Longest a tick had to wait after it was due
+};
+
+// Runs the ticks of every watchdog on a small pool of threads, instead of a thread each. Tasks are kept in a timer wheel, so finding the
+//   ones that are due doesn't depend on how many there are.
+// Ticks are due at fixed intervals from when the task was scheduled, so time spent running them doesn't add up as drift. A tick that
+//   finishes after the next one was due is an overrun: the ticks it ran over are skipped rather than run back to back. A task never runs
+//   on two threads at once.
+class WatchdogScheduler
+{
+public:
+	using Clock = std::function<std::chrono::nanoseconds()>;
+	// Called on each tick. It can change interval for the ticks after this one, and returns false to stop.
+	using Tick = std::function<bool(std::chrono::nanoseconds& interval)>;
+
+	// Ticks run on the given number of threads, by the steady clock.
+	WatchdogScheduler(int threads);
+	// Time is whatever clock returns, and ticks only run when runDue() is called. For tests.
+	WatchdogScheduler(Clock clock);
+	~WatchdogScheduler();
+
+	WatchdogScheduler(const WatchdogScheduler&) = delete;
+	WatchdogScheduler& operator=(const WatchdogScheduler&) = delete;
+
+	// The scheduler the watchdogs share.
+	static WatchdogScheduler& get();
+
+	// Call tick every interval, starting one interval from now. Returns the task's id.
+	uint64_t schedule(std::chrono::nanoseconds interval, Tick tick);
+	// Stop a task. Once this returns, its tick isn't running and won't run again, unless this was called from the tick itself.
+	void cancel(uint64_t id);
+	// Whether a task is still scheduled.
+	bool scheduled(uint64_t id);
+	ScheduledTaskStats stats(uint64_t id);
+
+	std::chrono::nanoseconds now() const { return _clock(); }
+	// Run every tick that is due, on this thread. Only for schedulers without threads. Returns the number of ticks run.
+	int runDue();
+
+private:
+	struct Task {
+		uint64_t id;
+		Tick tick;
+		std::chrono::nanoseconds interval;
+		std::chrono::nanoseconds deadline; // When the next tick is due
+		uint64_t slotTick; // The wheel tick it is filed under
+		bool queued = false; // Waiting for a thread to run it
+		bool running = false;
+		bool cancelled = false;
+		ScheduledTaskStats stats;
+	};
+
+	void file(const std::shared_ptr<Task>& task);
+	void advance(std::chrono::nanoseconds now);
+	bool run(const std::shared_ptr<Task>& task);
+	void finish(const std::shared_ptr<Task>& task, bool keep, std::chrono::nanoseconds interval);
+	void timerLoop();
+	void workerLoop();
+
+	Clock _clock;
+	std::mutex _mtx; // Everything below
+	std::condition_variable _timer; // A task was scheduled, or the scheduler is stopping
+	std::condition_variable _work; // Tasks are ready, or the scheduler is stopping
+	std::condition_variable _finished; // A tick finished
+	std::map<uint64_t, std::shared_ptr<Task>> _tasks;
+	std::array<std::vector<uint64_t>, SCHEDULER_WHEEL_SLOTS> _wheel; // Ids of the tasks due in each slot, in this turn or a later one
+	uint64_t _nextTick = 0; // The first wheel tick that hasn't been processed
+	std::deque<std::shared_ptr<Task>> _ready;
+	uint64_t _nextId = 1;
+	bool _stopping = false;
+	std::vector<std::thread> _threads;
+};